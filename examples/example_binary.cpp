@@ -0,0 +1,54 @@
+/// @file example_binary.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/binary_sink.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+int main(int, char *[])
+{
+    const char *log_filename = "binary.log";
+
+    {
+        // Write framed records, with a sync point every 256 bytes.
+        auto binary = std::make_shared<quire::binary_sink_t>(log_filename, 256);
+
+        quire::logger_t l0("l0", quire::log_level::debug, '|');
+        l0.set_output_stream(nullptr);
+        l0.add_sink(binary);
+
+        for (int i = 0; i < 10; ++i) {
+            qinfo(l0, "Binary record number %d\n", i);
+        }
+        qerror(l0, "Something went wrong: %d\n", 42);
+    }
+
+    // Read the file back, `quire-decode` does the same on many cores.
+    std::ifstream file(log_filename, std::ios::binary);
+    const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    quire::binary::record_view_t record;
+    std::size_t position = 0, length;
+    while (position < data.size()) {
+        const quire::binary::decode_result_t result = quire::binary::decode(data.data() + position, data.size() - position, record, length);
+        if (result == quire::binary::decode_result_t::record) {
+            std::cout << std::string(record.header, record.header_len) << " | "
+                      << std::string(record.location, record.location_len) << " | "
+                      << std::string(record.message, record.message_len) << "\n";
+        } else if (result == quire::binary::decode_result_t::sync) {
+            std::cout << "(sync point at " << position << ")\n";
+        } else if (result == quire::binary::decode_result_t::incomplete) {
+            std::cout << "(torn tail)\n";
+            break;
+        } else {
+            position = quire::binary::find_record(data.data(), data.size(), position + 1);
+            continue;
+        }
+        position += length;
+    }
+    return 0;
+}
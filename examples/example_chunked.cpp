@@ -0,0 +1,38 @@
+/// @file example_chunked.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/quire.hpp>
+#include <quire/sink.hpp>
+
+#include <iostream>
+#include <string>
+
+int main(int, char *[])
+{
+    quire::logger_t l0("l0", quire::log_level::debug, '|');
+
+    // A record written piece by piece, the header is rendered once.
+    if (l0.begin_record(quire::info, __FILE__, __LINE__)) {
+        l0.append("Response body: ");
+        for (int i = 0; i < 5; ++i) {
+            l0.append(std::to_string(i) + " ");
+        }
+        l0.end_record();
+    }
+
+    // A large payload goes to the file in chunks, and is never assembled.
+    l0.set_output_sink(nullptr);
+    l0.set_file_sink(std::make_shared<quire::file_sink_t>("chunked.log"));
+    const std::string chunk(1U << 20U, 'x');
+    {
+        // The guard ends the record, even if an exception is thrown.
+        quire::record_guard_t<quire::logger_t> record(l0, quire::debug, __FILE__, __LINE__);
+        for (int i = 0; i < 100; ++i) {
+            record.append(chunk.data(), chunk.size());
+        }
+    }
+    l0.set_file_sink(nullptr);
+    std::cout << "Wrote 100 MiB to chunked.log, in a single record.\n";
+    return 0;
+}
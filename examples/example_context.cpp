@@ -0,0 +1,42 @@
+/// @file example_context.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/quire.hpp>
+#include <quire/context.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief Handles a request, its lines carry the context of the caller.
+void handle(quire::logger_t &logger, const std::string &user)
+{
+    quire::context_guard_t guard("user", user);
+    qinfo(logger, "Handling the request\n");
+    qdebug(logger, "Request handled\n");
+}
+
+int main(int, char *[])
+{
+    quire::logger_t l0(
+        "l0", quire::log_level::debug, '|',
+        { quire::option_t::header, quire::option_t::level, quire::option_t::context, quire::option_t::location });
+
+    qinfo(l0, "No context yet\n");
+
+    std::vector<std::thread> threads;
+    for (int request = 0; request < 4; ++request) {
+        threads.emplace_back([&l0, request]() {
+            quire::context_guard_t guard("req", request);
+            handle(l0, request % 2 ? "alice" : "bob");
+            qinfo(l0, "Back to the request\n");
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    qinfo(l0, "No context anymore\n");
+    return 0;
+}
@@ -0,0 +1,35 @@
+/// @file example_hexdump.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/quire.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+int main(int, char *[])
+{
+    quire::logger_t l0("l0", quire::log_level::debug, '|');
+
+    // A packet, its last row is shorter than the others.
+    const char packet[] = "GET /index.html HTTP/1.1\r\nHost: example.com\r\n\r\n";
+    qhexdump(l0, quire::debug, packet, sizeof(packet));
+
+    // Measure the throughput, writing to memory.
+    std::ostringstream stream;
+    l0.set_output_stream(&stream);
+    std::vector<unsigned char> data(1U << 24U);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(i * 7);
+    }
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    qhexdump(l0, quire::info, data.data(), data.size());
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    const double seconds   = std::chrono::duration<double>(end - begin).count();
+    const double megabytes = static_cast<double>(data.size() >> 20U);
+    std::cout << "Dumped " << megabytes << " MiB in " << seconds << " s, " << megabytes / seconds << " MiB/s\n";
+    return 0;
+}
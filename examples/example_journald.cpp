@@ -0,0 +1,88 @@
+/// @file example_journald.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/journald_sink.hpp>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <cstring>
+#include <cctype>
+#include <string>
+
+/// @brief Prints an entry, making the binary fields readable.
+void print_entry(const char *data, std::size_t length)
+{
+    std::cout << "--- entry (" << length << " bytes)\n";
+    for (std::size_t i = 0; i < length; ++i) {
+        std::cout << ((data[i] == '\n') || std::isprint(static_cast<unsigned char>(data[i])) ? data[i] : '.');
+    }
+}
+
+int main(int, char *[])
+{
+    // A local stand-in for the socket of systemd-journald.
+    std::string socket_path = "/tmp/quire-journald-" + std::to_string(::getpid()) + ".sock";
+    int server              = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    if (::bind(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        std::cerr << "Failed to bind `" << socket_path << "`.\n";
+        return 1;
+    }
+
+    // Send the lines to the stand-in, and pass large ones through a memfd.
+    auto journal = std::make_shared<quire::journald_sink_t>(socket_path);
+    journal->set_max_datagram_size(256);
+
+    quire::logger_t l0("l0", quire::log_level::debug, '|');
+    l0.set_output_stream(nullptr);
+    l0.add_sink(journal);
+
+    qinfo(l0, "Hello there, journal!\n");
+    qerror(l0, "Something went wrong: %d\n", 42);
+    qwarning(l0, "A large record: %s\n", std::string(400, 'x').c_str());
+
+    // Receive the entries.
+    for (int i = 0; i < 3; ++i) {
+        char data[1024];
+        union {
+            cmsghdr header;
+            char data[CMSG_SPACE(sizeof(int))];
+        } control;
+        iovec vector = { data, sizeof(data) };
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov        = &vector;
+        message.msg_iovlen     = 1;
+        message.msg_control    = control.data;
+        message.msg_controllen = sizeof(control.data);
+        ssize_t length         = ::recvmsg(server, &message, MSG_DONTWAIT);
+        if (length < 0) {
+            break;
+        }
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+        if ((cmsg != nullptr) && (cmsg->cmsg_type == SCM_RIGHTS)) {
+            // The entry was passed through a memfd.
+            int memfd;
+            std::memcpy(&memfd, CMSG_DATA(cmsg), sizeof(int));
+            char content[1024];
+            ssize_t content_length = ::pread(memfd, content, sizeof(content), 0);
+            ::close(memfd);
+            std::cout << "(memfd) ";
+            print_entry(content, static_cast<std::size_t>(content_length));
+        } else {
+            print_entry(data, static_cast<std::size_t>(length));
+        }
+    }
+    std::cout << "dropped: " << journal->get_dropped() << "\n";
+
+    ::close(server);
+    ::unlink(socket_path.c_str());
+    return 0;
+}
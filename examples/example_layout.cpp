@@ -0,0 +1,32 @@
+/// @file example_layout.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/quire.hpp>
+
+/// @brief A layout fixed at compile time.
+using layout_t = quire::layout_t<quire::column::header, quire::column::level, quire::column::time, quire::column::location>;
+
+int main(int, char *[])
+{
+    quire::basic_logger_t<layout_t> l0("l0", quire::log_level::debug, '|');
+
+    qdebug(l0, "Hello there!\n");
+    qinfo(l0, "The layout of this logger is fixed at compile time.\n");
+    qwarning(l0, "%2d\n", 10);
+    qerror(l0, "%.2f\n", 3.14);
+
+    l0.set_log_level(quire::log_level::error);
+    qwarning(l0, "This is not shown.\n");
+    qcritical(l0, "This is shown.\n");
+
+    // A logger used only by this thread, it does not pay for a mutex.
+    quire::basic_logger_t<layout_t, quire::null_lock_t> l1("l1", quire::log_level::debug, '|');
+    qinfo(l1, "I'm confined to the main thread.\n");
+
+    // A logger protected by a lock that spins before parking the thread.
+    quire::basic_logger_t<layout_t, quire::spin_lock_t> l2("l2", quire::log_level::debug, '|');
+    qinfo(l2, "I'm protected by a spin lock.\n");
+
+    return 0;
+}
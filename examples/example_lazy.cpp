@@ -0,0 +1,36 @@
+/// @file example_lazy.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/quire.hpp>
+
+#include <iostream>
+#include <string>
+
+/// @brief Counts how many times the state was dumped.
+static int dumps = 0;
+
+/// @brief An expensive diagnostic.
+std::string dump_state()
+{
+    ++dumps;
+    return "state = { a: 1, b: 2 }";
+}
+
+int main(int, char *[])
+{
+    quire::logger_t l0("l0", quire::log_level::info, '|');
+
+    // The arguments are evaluated only if the message is written.
+    qdebug(l0, "%s\n", dump_state().c_str());
+    qinfo(l0, "%s\n", dump_state().c_str());
+
+    // The callable runs only if the message is written.
+    int a = 1, b = 2;
+    qdebug_lazy(l0, [&a, &b]() { return dump_state() + " " + std::to_string(a + b) + "\n"; });
+    qinfo_lazy(l0, [&a, &b]() { return dump_state() + " " + std::to_string(a + b) + "\n"; });
+    qwarning_lazy(l0, []() { return "A plain string.\n"; });
+
+    std::cout << "The state was dumped " << dumps << " times, instead of 4.\n";
+    return 0;
+}
@@ -3,6 +3,7 @@
 /// @brief
 
 #include <quire/quire.hpp>
+#include <quire/sink.hpp>
 
 #include <iostream>
 
@@ -29,5 +30,17 @@ int main(int, char *[])
 
     qdebug(l0, "Hello there, I'm logging on file!\n");
 
+    // A file sink opened in append mode, each line is written with a single
+    // write() call, so many processes can safely append to the same file.
+    // The sink also writes a sparse time index, used by `quire-seek`.
+    auto file_sink = std::make_shared<quire::file_sink_t>(log_filename);
+    file_sink->set_time_index();
+    quire::logger_t l1("L1", quire::log_level::debug, '|');
+    l1.set_file_sink(file_sink);
+    l1.set_output_stream(nullptr);
+    l1.configure(quire::logger_t::get_show_all_configuation());
+
+    qdebug(l1, "Hello there, I'm appending to the same file!\n");
+
     return 0;
 }
\ No newline at end of file
@@ -3,9 +3,11 @@
 /// @brief
 
 #include <quire/registry.hpp>
+#include <quire/context.hpp>
 
 #include <condition_variable>
 #include <iostream>
+#include <fstream>
 #include <chrono>
 #include <thread>
 #include <mutex>
@@ -28,6 +30,7 @@ std::mutex mtx;
 
 void producer_fun()
 {
+    quire::set_thread_name("producer");
     auto &local = quire::get_logger(channel_local);
     std::this_thread::sleep_for(std::chrono::milliseconds(1));
     product.a     = 2;
@@ -39,6 +42,7 @@ void producer_fun()
 
 void consumer_fun()
 {
+    quire::set_thread_name("consumer");
     std::unique_lock<std::mutex> lock(mtx);
     auto &global = quire::get_logger(channel_global);
     condition.wait(lock, [&]() { return product.ready; });
@@ -60,11 +64,29 @@ int main(int, char *[])
     admin.set_color(quire::debug, quire::ansi::fg::bright_red, quire::ansi::util::reset);
     admin.configure(quire::logger_t::get_show_all_configuation());
 
+    // Show which thread wrote each line of the local logger, by name, or by
+    // identifier for the threads that were not named.
+    local.configure({ quire::option_t::header, quire::option_t::level, quire::option_t::thread, quire::option_t::location });
+
+    // All loggers share the same file sink, with a single buffer and lock.
+    std::ofstream file_stream("multithread.log", std::ios::out | std::ios::app);
+    auto file = quire::add_sink("file", std::make_shared<quire::ostream_sink_t>(&file_stream));
+    file->set_buffer_capacity(4096).set_flush_level(quire::error);
+    local.set_file_sink(file);
+    global.set_file_sink(file);
+    admin.set_file_sink(file);
+
+    // Pay the cost of the first log call now, rather than in the threads.
+    quire::registry_t::instance().warmup_all();
+
     std::thread producer(producer_fun);
     std::thread consumer(consumer_fun);
 
     producer.join();
     consumer.join();
 
+    // Write the buffered lines before the file stream is closed.
+    quire::registry_t::instance().flush_sinks();
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+/// @file example_pattern.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/quire.hpp>
+#include <quire/pattern.hpp>
+#include <quire/context.hpp>
+
+#include <iostream>
+
+int main(int, char *[])
+{
+    quire::logger_t l0("l0", quire::log_level::debug, '|');
+
+    qinfo(l0, "The configured options.\n");
+
+    // The pattern is compiled once, here.
+    l0.set_pattern("[%T.%ms] %-8L %H {%tid} %-24loc: %msg");
+    quire::set_thread_name("main");
+    qdebug(l0, "Hello there!\n");
+    qwarning(l0, "%2d\n", 10);
+
+    // Fields can be right-aligned too, and show the context of the thread.
+    l0.set_pattern("%D %T.%us %8L %ctx | %msg");
+    {
+        quire::context_guard_t guard("req", 7);
+        qerror(l0, "%.2f\n", 3.14);
+    }
+
+    // Invalid patterns are rejected, and the logger keeps its layout.
+    try {
+        l0.set_pattern("%T %msg %L");
+    } catch (const quire::pattern_exception_t &e) {
+        std::cout << e.what() << "\n";
+    }
+    qcritical(l0, "Still using the previous pattern.\n");
+
+    // An empty pattern goes back to the configured options.
+    l0.set_pattern("");
+    qinfo(l0, "The configured options, again.\n");
+    return 0;
+}
@@ -55,5 +55,16 @@ int main(int, char *[])
     l0.set_header("L0");
     l0.log(quire::info, "%2d\n", 10);
 
+    // User-controlled text cannot forge lines or escape sequences.
+    const char *user = "bob\n[fake] admin logged in\33[2J\xff";
+    l0.toggle_sanitize(true);
+    qinfo(l0, "Hello %s\n", user);
+    l0.toggle_sanitize(false);
+
+    // Long messages are truncated, and the buffer shrinks back after them.
+    l0.set_max_message_size(128).set_buffer_shrink_size(4096);
+    qinfo(l0, "%0200d\n", 1);
+    l0.set_max_message_size(0);
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,45 @@
+/// @file example_sites.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/site.hpp>
+
+#include <iostream>
+
+/// @brief Simulates some work, with debug messages.
+void process(quire::logger_t &logger, int request)
+{
+    qdebug(logger, "Parsing request %d\n", request);
+    qdebug(logger, "Retrying request %d\n", request);
+    qinfo(logger, "Served request %d\n", request);
+}
+
+int main(int, char *[])
+{
+    // The logger only shows info and above.
+    quire::logger_t l0("l0", quire::log_level::info, '|');
+
+    std::cout << "Default, only info messages:\n";
+    process(l0, 0);
+
+    // Turn on a single debug statement, selecting it by its format.
+    quire::enable_sites(quire::site_filter_t().with_format("Retrying"));
+    std::cout << "Retries enabled:\n";
+    process(l0, 1);
+
+    // Turn off every statement of a range of lines of this file.
+    quire::disable_sites(quire::site_filter_t().in_file("example_sites.cpp").in_lines(12, 15));
+    std::cout << "Lines 12-15 disabled:\n";
+    process(l0, 2);
+
+    // Let the level of the logger decide again.
+    quire::reset_sites();
+    std::cout << "Reset:\n";
+    process(l0, 3);
+
+    std::cout << "Registered sites:\n";
+    for (const quire::site_t *site : quire::site_registry_t::instance().get_sites()) {
+        std::cout << "    " << site->get_file() << ":" << site->get_line() << " `" << site->get_format() << "`\n";
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+/// @file example_socket.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/socket_sink.hpp>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <thread>
+
+/// @brief Reads what the collector received, until nothing is left.
+/// @return The number of bytes.
+std::size_t receive_all(int client)
+{
+    std::size_t total = 0;
+    char data[65536];
+    ssize_t length;
+    while ((length = ::recv(client, data, sizeof(data), MSG_DONTWAIT)) > 0) {
+        total += static_cast<std::size_t>(length);
+    }
+    return total;
+}
+
+int main(int, char *[])
+{
+    // == UNIX socket =========================================================
+    std::string socket_path = "/tmp/quire-collector-" + std::to_string(::getpid()) + ".sock";
+
+    auto unix_sink = std::make_shared<quire::socket_sink_t>(socket_path);
+    unix_sink->set_reconnect_backoff(std::chrono::milliseconds(10), std::chrono::milliseconds(100));
+
+    quire::logger_t l0("l0", quire::log_level::debug, '|');
+    l0.set_output_stream(nullptr);
+    l0.add_sink(unix_sink);
+
+    // The collector is not there yet, the lines wait in the outgoing buffer.
+    for (int i = 0; i < 1000; ++i) {
+        qinfo(l0, "Waiting for the collector %d\n", i);
+    }
+    l0.flush();
+    std::cout << "Connected: " << unix_sink->is_connected() << ", pending: " << unix_sink->get_pending_size() << " bytes\n";
+
+    // The local stand-in for the collector.
+    int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    if ((::bind(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) || (::listen(server, 1) != 0)) {
+        std::cerr << "Failed to listen on `" << socket_path << "`.\n";
+        return 1;
+    }
+
+    // Once the backoff expires, the next flush connects and sends everything.
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    l0.flush();
+    int client = ::accept(server, nullptr, nullptr);
+    std::cout << "Connected: " << unix_sink->is_connected() << ", pending: " << unix_sink->get_pending_size() << " bytes\n";
+    std::cout << "Received: " << receive_all(client) << " bytes, dropped: " << unix_sink->get_dropped() << " bytes\n";
+    ::close(client);
+    ::close(server);
+    ::unlink(socket_path.c_str());
+
+    // == TCP loopback ========================================================
+    int tcp_server = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in tcp_address;
+    std::memset(&tcp_address, 0, sizeof(tcp_address));
+    tcp_address.sin_family      = AF_INET;
+    tcp_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t tcp_address_len   = sizeof(tcp_address);
+    if ((::bind(tcp_server, reinterpret_cast<sockaddr *>(&tcp_address), sizeof(tcp_address)) != 0) ||
+        (::listen(tcp_server, 1) != 0) ||
+        (::getsockname(tcp_server, reinterpret_cast<sockaddr *>(&tcp_address), &tcp_address_len) != 0)) {
+        std::cerr << "Failed to listen on the loopback.\n";
+        return 1;
+    }
+
+    auto tcp_sink = std::make_shared<quire::socket_sink_t>("127.0.0.1", ntohs(tcp_address.sin_port));
+    tcp_sink->set_buffer_capacity(16384);
+
+    quire::logger_t l1("l1", quire::log_level::debug, '|');
+    l1.set_output_stream(nullptr);
+    l1.add_sink(tcp_sink);
+
+    for (int i = 0; i < 1000; ++i) {
+        qdebug(l1, "Shipping line %d over TCP\n", i);
+    }
+    l1.flush();
+    int tcp_client = ::accept(tcp_server, nullptr, nullptr);
+    l1.flush();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::cout << "Received: " << receive_all(tcp_client) << " bytes, dropped: " << tcp_sink->get_dropped() << " bytes\n";
+    ::close(tcp_client);
+    ::close(tcp_server);
+    return 0;
+}
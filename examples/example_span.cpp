@@ -0,0 +1,67 @@
+/// @file example_span.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/span.hpp>
+#include <quire/sink.hpp>
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/// @brief Simulates parsing and evaluating an expression, measuring both.
+int evaluate(quire::logger_t &logger, int seed)
+{
+    qspan(logger, "evaluate");
+    int result = seed;
+    {
+        qspan(logger, "parse");
+        for (int i = 0; i < 1000; ++i) {
+            result = (result * 31 + i) % 1000003;
+        }
+    }
+    {
+        qspan(logger, "reduce");
+        for (int i = 0; i < 2000; ++i) {
+            result = (result * 17 + i) % 1000003;
+        }
+    }
+    return result;
+}
+
+int main(int, char *[])
+{
+    quire::logger_t l0("l0", quire::log_level::debug, '|');
+
+    // Without a trace, spans are logged as debug lines.
+    evaluate(l0, 1);
+
+    // With a trace, spans are recorded and written as trace events, open
+    // span.json with chrome://tracing or https://ui.perfetto.dev.
+    quire::tracer_t &tracer = quire::tracer_t::instance();
+    tracer.start(std::make_shared<quire::file_sink_t>("span.json"));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&l0, t]() {
+            for (int i = 0; i < 100; ++i) {
+                evaluate(l0, t * 100 + i);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    tracer.stop();
+
+    // Measure the cost of recording a span, and writing it to the trace.
+    tracer.start(std::make_shared<quire::file_sink_t>("span_bench.json"));
+    const int count                = 1000000;
+    const std::int64_t bench_begin = quire::span_t::now();
+    for (int i = 0; i < count; ++i) {
+        qspan(l0, "empty");
+    }
+    const std::int64_t bench_end = quire::span_t::now();
+    tracer.stop();
+    std::cout << "Recording and writing a span takes " << static_cast<double>(bench_end - bench_begin) / count << " ns\n";
+    return 0;
+}
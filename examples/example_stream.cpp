@@ -0,0 +1,42 @@
+/// @file example_stream.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/stream.hpp>
+
+#include <iomanip>
+
+/// @brief A type providing its own operator<<.
+struct point_t {
+    double x; ///< The x coordinate.
+    double y; ///< The y coordinate.
+};
+
+std::ostream &operator<<(std::ostream &os, const point_t &p)
+{
+    return os << "(" << p.x << ", " << p.y << ")";
+}
+
+/// @brief An expensive function, which is not called when the level is disabled.
+int expensive()
+{
+    return 42;
+}
+
+int main(int, char *[])
+{
+    quire::logger_t l0("l0", quire::log_level::debug, '|');
+    l0.configure(quire::logger_t::get_show_all_configuation());
+
+    point_t p = { 1.5, -2.0 };
+
+    qdebug_s(l0) << "The point is " << p;
+    qinfo_s(l0) << "Formatting works as usual: " << std::setw(6) << std::setfill('0') << 42;
+    qinfo_s(l0) << "And it is reset for each record: " << 42;
+
+    l0.set_log_level(quire::log_level::info);
+    qdebug_s(l0) << "This is not shown, and expensive() is not called: " << expensive();
+    qwarning_s(l0) << "This is shown: " << expensive();
+
+    return 0;
+}
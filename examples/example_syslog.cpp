@@ -0,0 +1,75 @@
+/// @file example_syslog.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include <quire/syslog_sink.hpp>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <cstring>
+#include <string>
+
+/// @brief Receives and prints the records waiting on the socket.
+/// @return The number of records.
+int receive_records(int server)
+{
+    int count = 0;
+    char data[2048];
+    ssize_t length;
+    while ((length = ::recv(server, data, sizeof(data), MSG_DONTWAIT)) > 0) {
+        std::cout << std::string(data, static_cast<std::size_t>(length)) << "\n";
+        ++count;
+    }
+    return count;
+}
+
+int main(int, char *[])
+{
+    // A local stand-in for /dev/log, with a small receive buffer, to play
+    // the part of a slow daemon.
+    std::string socket_path = "/tmp/quire-syslog-" + std::to_string(::getpid()) + ".sock";
+    int server              = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+    int receive_size        = 4096;
+    ::setsockopt(server, SOL_SOCKET, SO_RCVBUF, &receive_size, sizeof(receive_size));
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    if (::bind(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        std::cerr << "Failed to bind `" << socket_path << "`.\n";
+        return 1;
+    }
+
+    // Send the lines to the stand-in, as the `local0` facility.
+    auto syslog = std::make_shared<quire::syslog_sink_t>(socket_path, 16);
+    syslog->set_max_backlog_size(4096);
+
+    quire::logger_t l0("l0", quire::log_level::debug, '|');
+    l0.set_output_stream(nullptr);
+    l0.add_sink(syslog);
+
+    qinfo(l0, "Hello there, syslog!\n");
+    qerror(l0, "Something went wrong: %d\n", 42);
+
+    // The daemon does not keep up, the records wait in the backlog.
+    for (int i = 0; i < 100; ++i) {
+        qdebug(l0, "Record number %d\n", i);
+    }
+    std::cout << "Backlog: " << syslog->get_backlog_size() << " bytes, dropped: " << syslog->get_dropped() << "\n";
+
+    // Receive the records, while the sink sends the backlog.
+    int received = 0;
+    do {
+        received += receive_records(server);
+        l0.flush();
+    } while (syslog->get_backlog_size() > 0);
+    received += receive_records(server);
+    std::cout << "Received: " << received << ", dropped: " << syslog->get_dropped() << "\n";
+
+    ::close(server);
+    ::unlink(socket_path.c_str());
+    return 0;
+}
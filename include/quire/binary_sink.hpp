@@ -0,0 +1,149 @@
+/// @file binary_sink.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Defines a sink writing framed binary records, and the functions
+/// needed to decode them.
+
+#pragma once
+
+#include "quire/sink.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace quire
+{
+
+/// @brief The binary log format.
+/// @details A binary log is a sequence of records and sync points. Each
+/// record is framed as:
+///     magic (4 bytes) | length (4 bytes) | checksum (4 bytes) | payload
+/// where the length is the size of the payload, and the checksum is the
+/// CRC-32C of the length and the payload. The payload holds the time
+/// (8 bytes, microseconds since the epoch), the level (1 byte), the lengths
+/// of the header and of the location (2 bytes each), followed by the
+/// header, the location and the message. Numbers are little-endian.
+///
+/// A sync point is a fixed 16-byte marker written regularly between two
+/// records. A decoder starting at an arbitrary offset looks for the next
+/// sync point, and decodes the records that follow it; this way a file can
+/// be split in chunks decoded in parallel.
+namespace binary
+{
+
+/// @brief Size of the frame in front of the payload.
+const std::size_t frame_size = 12;
+
+/// @brief Size of the fixed part of the payload.
+const std::size_t payload_header_size = 13;
+
+/// @brief Maximum size of a payload, longer messages are truncated.
+const std::size_t max_payload_size = 16U << 20U;
+
+/// @brief Size of the sync marker.
+const std::size_t sync_size = 16;
+
+/// @brief The magic number starting each record.
+extern const char magic[4];
+
+/// @brief The sync marker.
+extern const char sync_marker[sync_size];
+
+/// @brief A decoded record, pointing inside the decoded data.
+struct record_view_t {
+    std::int64_t time;        ///< When the line was written, in microseconds since the epoch.
+    log_level level;          ///< Log level of the line.
+    const char *header;       ///< Header of the logger.
+    std::size_t header_len;   ///< Length of the header.
+    const char *location;     ///< Source location.
+    std::size_t location_len; ///< Length of the location.
+    const char *message;      ///< The message.
+    std::size_t message_len;  ///< Length of the message.
+};
+
+/// @brief Outcome of decoding.
+enum class decode_result_t {
+    record,     ///< A record was decoded.
+    sync,       ///< A sync point was found.
+    incomplete, ///< The data ends before the end of the record.
+    corrupt     ///< The data is neither a record nor a sync point.
+};
+
+/// @brief Computes the CRC-32C of the data.
+/// @param data The data.
+/// @param length Length of the data.
+/// @param crc The CRC of the data before this one, to compute it in parts.
+/// @return The CRC.
+std::uint32_t crc32c(const void *data, std::size_t length, std::uint32_t crc = 0);
+
+/// @brief Decodes the record, or the sync point, at the start of the data.
+/// @param data The data.
+/// @param length Length of the data.
+/// @param record The decoded record.
+/// @param size The size of what was decoded.
+/// @return The outcome.
+decode_result_t decode(const char *data, std::size_t length, record_view_t &record, std::size_t &size);
+
+/// @brief Finds the first sync point at or after the given offset, and
+/// checks that a record, another sync point, or the end of the data follows it.
+/// @param data The data.
+/// @param length Length of the data.
+/// @param offset Where to start looking.
+/// @return The offset of the sync point, or length if there is none.
+std::size_t find_sync(const char *data, std::size_t length, std::size_t offset);
+
+/// @brief Finds the first valid record at or after the given offset, used
+/// to resynchronize after corrupt data.
+/// @param data The data.
+/// @param length Length of the data.
+/// @param offset Where to start looking.
+/// @return The offset of the record or of the sync point, or length if there is none.
+std::size_t find_record(const char *data, std::size_t length, std::size_t offset);
+
+} // namespace binary
+
+/// @brief A sink appending framed binary records to a file, opened with
+/// O_APPEND like file_sink_t, so it can be shared by many processes.
+/// @details Each write() call starts at a record boundary and contains whole
+/// records, and a sync point is added in front of a write every time enough
+/// bytes have been written since the last one.
+class binary_sink_t : public sink_t {
+public:
+    /// @brief Opens the file, creating it if needed.
+    /// @param _path Path of the file.
+    /// @param _sync_interval Bytes between two sync points.
+    /// @param _atomic_write_size Maximum size of a single write() call.
+    /// @throws sink_exception_t if the file cannot be opened.
+    explicit binary_sink_t(const std::string &_path, std::size_t _sync_interval = 65536, std::size_t _atomic_write_size = 65536);
+
+    /// @brief Flushes the remaining records and closes the file.
+    ~binary_sink_t() override;
+
+    /// @brief Returns the path of the file.
+    const std::string &get_path() const;
+
+protected:
+    void append_line(std::string &out, const line_t &line) override;
+
+    bool streams_records() const override;
+
+    void write_device(const char *data, std::size_t length) override;
+
+    void flush_device() override;
+
+    /// @brief Writes a chunk with a single write() call, with a sync point
+    /// in front of it if needed.
+    /// @param data The records.
+    /// @param length Length of the records.
+    void write_chunk(const char *data, std::size_t length);
+
+private:
+    std::string path;                     ///< Path of the file.
+    int fd;                               ///< File descriptor.
+    std::size_t sync_interval;            ///< Bytes between two sync points.
+    std::size_t atomic_write_size;        ///< Maximum size of a single write() call.
+    std::size_t since_sync;               ///< Bytes written since the last sync point.
+    std::vector<std::size_t> record_ends; ///< End of each record inside the buffer.
+    std::string chunk;                    ///< The chunk being written.
+};
+
+} // namespace quire
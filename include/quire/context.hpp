@@ -0,0 +1,60 @@
+/// @file context.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Defines the diagnostic context and the name of each thread, shown
+/// by the context and thread columns of the loggers.
+
+#pragma once
+
+#include <string>
+
+namespace quire
+{
+
+/// @brief Adds a key and a value to the context of the calling thread,
+/// until the guard goes out of scope.
+/// @details The context is rendered when a guard is created or destroyed,
+/// so that the loggers only copy it. Guards of the same thread must be
+/// destroyed in the reverse order of their creation, as scopes do.
+class context_guard_t {
+public:
+    /// @brief Adds the key and the value to the context.
+    /// @param key The key.
+    /// @param value The value.
+    context_guard_t(const char *key, const std::string &value);
+
+    /// @brief Adds the key and the value to the context.
+    /// @param key The key.
+    /// @param value The value.
+    context_guard_t(const char *key, long long value);
+
+    /// @brief Removes the key and the value from the context.
+    ~context_guard_t();
+
+    context_guard_t(const context_guard_t &)            = delete;
+    context_guard_t &operator=(const context_guard_t &) = delete;
+
+    /// @brief Returns the rendered context of the calling thread, e.g.,
+    /// "req=42 user=bob", empty if there is none.
+    static const std::string &current();
+
+private:
+    /// @brief Appends the key and the value to the context.
+    /// @param key The key.
+    /// @param value The value.
+    /// @param length The length of the value.
+    void push(const char *key, const char *value, std::size_t length);
+
+    std::size_t previous_length; ///< Length of the context before this guard.
+};
+
+/// @brief Names the calling thread, the name is shown by the thread column.
+/// @param name The name, empty to go back to the thread identifier.
+void set_thread_name(const std::string &name);
+
+/// @brief Returns the name of the calling thread, which is its identifier
+/// given by the operating system, unless it was named with set_thread_name.
+/// The name is computed once per thread, then cached.
+/// @return The name of the thread.
+const std::string &get_thread_name();
+
+} // namespace quire
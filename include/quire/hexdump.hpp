@@ -0,0 +1,29 @@
+/// @file hexdump.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Defines the rendering of binary data as hexdump rows, with the
+/// offset, the bytes in hexadecimal and their printable characters.
+
+#pragma once
+
+#include <cstddef>
+
+namespace quire
+{
+
+/// @brief Bytes shown by each row of a hexdump.
+static const std::size_t hexdump_row_bytes = 16;
+
+/// @brief Length of a row of a hexdump, newline included, e.g.:
+/// "00000010  6f 20 77 6f 72 6c 64 0a  00 01 02 03 04 05 06 07  |o world.........|\n"
+static const std::size_t hexdump_row_length = 79;
+
+/// @brief Renders a row of a hexdump.
+/// @param out The output, it must hold hexdump_row_length characters.
+/// @param offset Offset of the row, shown at its start.
+/// @param data The bytes of the row.
+/// @param length Number of bytes, at most hexdump_row_bytes, a shorter row
+/// is padded so that its characters stay aligned with the other rows.
+/// @return The length of the row.
+std::size_t render_hexdump_row(char *out, std::size_t offset, const unsigned char *data, std::size_t length);
+
+} // namespace quire
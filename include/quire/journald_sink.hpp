@@ -0,0 +1,77 @@
+/// @file journald_sink.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Defines a sink speaking the native protocol of systemd-journald.
+
+#pragma once
+
+#include "quire/sink.hpp"
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <vector>
+
+namespace quire
+{
+
+/// @brief A sink sending each line as a journal entry, through the native
+/// datagram protocol of systemd-journald.
+/// @details The level is mapped to PRIORITY, the header of the logger to
+/// SYSLOG_IDENTIFIER, and the location to CODE_FILE and CODE_LINE. When the
+/// sink buffers lines, the entries are sent in batches with a single
+/// sendmmsg() call. Entries that do not fit in a datagram are written to a
+/// sealed memfd, whose descriptor is passed to the daemon instead.
+class journald_sink_t : public sink_t {
+public:
+    /// @brief Opens the socket.
+    /// @param _socket_path Path of the socket of the daemon, it can point to
+    /// a local stand-in, for testing.
+    /// @throws sink_exception_t if the socket cannot be created.
+    explicit journald_sink_t(const std::string &_socket_path = "/run/systemd/journal/socket");
+
+    /// @brief Sends the remaining entries and closes the socket.
+    ~journald_sink_t() override;
+
+    /// @brief Returns the path of the socket of the daemon.
+    const std::string &get_socket_path() const;
+
+    /// @brief Returns the number of entries that could not be delivered.
+    std::size_t get_dropped() const;
+
+    /// @brief Sets the size above which entries are passed through a memfd.
+    /// @param _max_datagram_size The size in bytes.
+    /// @return Reference to the sink.
+    journald_sink_t &set_max_datagram_size(std::size_t _max_datagram_size);
+
+protected:
+    void append_line(std::string &out, const line_t &line) override;
+
+    bool streams_records() const override;
+
+    void write_device(const char *data, std::size_t length) override;
+
+    void flush_device() override;
+
+    /// @brief Sends the given entries, with as few system calls as possible.
+    /// @param entries Pointers to the entries.
+    /// @param lengths Lengths of the entries.
+    /// @param count Number of entries.
+    void send_batch(const char *const *entries, const std::size_t *lengths, std::size_t count);
+
+    /// @brief Sends an entry too large for a datagram, through a sealed memfd.
+    /// @param data The entry.
+    /// @param length Length of the entry.
+    /// @return true on success, false otherwise.
+    bool send_memfd(const char *data, std::size_t length);
+
+private:
+    std::string socket_path;             ///< Path of the socket of the daemon.
+    int fd;                              ///< The socket.
+    std::size_t max_datagram_size;       ///< Entries above this size use a memfd.
+    std::vector<std::size_t> entry_ends; ///< End of each entry inside the buffer.
+    std::atomic<std::size_t> dropped;    ///< Entries that could not be delivered.
+};
+
+} // namespace quire
+
+#endif
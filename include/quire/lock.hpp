@@ -0,0 +1,132 @@
+/// @file lock.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Locking policies that can be used to parametrize the loggers.
+
+#pragma once
+
+#include <condition_variable>
+#include <cassert>
+#include <atomic>
+#include <thread>
+#include <mutex>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace quire
+{
+
+namespace detail
+{
+
+/// @brief Tells the processor that we are inside a spin-wait loop.
+inline void cpu_relax()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_ia32_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__aarch64__) || defined(__arm__))
+    __asm__ __volatile__("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+} // namespace detail
+
+/// @brief A lock that does nothing, for loggers used by a single thread.
+/// @details In debug builds, it checks that the logger is always used by the
+/// thread that locked it first.
+class null_lock_t {
+public:
+    /// @brief Constructs the lock.
+    null_lock_t() noexcept
+#ifndef NDEBUG
+        : owner()
+#endif
+    {
+        // Nothing to do.
+    }
+
+    /// @brief Does nothing, in debug builds checks the calling thread.
+    void lock() noexcept
+    {
+#ifndef NDEBUG
+        std::thread::id expected;
+        std::thread::id current = std::this_thread::get_id();
+        // Bind the lock to the first thread using it.
+        if (!owner.compare_exchange_strong(expected, current)) {
+            assert((expected == current) && "A thread-confined logger is being used by a second thread.");
+        }
+#endif
+    }
+
+    /// @brief Does nothing.
+    void unlock() noexcept
+    {
+        // Nothing to do.
+    }
+
+private:
+#ifndef NDEBUG
+    std::atomic<std::thread::id> owner; ///< The thread the lock is confined to.
+#endif
+};
+
+/// @brief A lock that spins for a while before parking the thread, meant for
+/// short critical sections.
+class spin_lock_t {
+public:
+    /// @brief Constructs the lock.
+    /// @param _spin_count How many times we try to acquire the lock before parking.
+    explicit spin_lock_t(unsigned _spin_count = 100) noexcept
+        : locked(false),
+          waiters(0),
+          spin_count(_spin_count),
+          park_mtx(),
+          park_cv()
+    {
+        // Nothing to do.
+    }
+
+    /// @brief Acquires the lock.
+    void lock()
+    {
+        // Spin for a while, hoping the owner releases the lock soon.
+        for (unsigned i = 0; i < spin_count; ++i) {
+            if (!locked.load(std::memory_order_relaxed) && !locked.exchange(true)) {
+                return;
+            }
+            detail::cpu_relax();
+        }
+        // Park the thread until the lock is released.
+        std::unique_lock<std::mutex> park_lock(park_mtx);
+        ++waiters;
+        while (locked.exchange(true)) {
+            park_cv.wait(park_lock);
+        }
+        --waiters;
+    }
+
+    /// @brief Releases the lock.
+    void unlock()
+    {
+        locked.store(false);
+        // Wake up one of the parked threads, if any.
+        if (waiters.load() > 0) {
+            std::lock_guard<std::mutex> park_lock(park_mtx);
+            park_cv.notify_one();
+        }
+    }
+
+private:
+    std::atomic<bool> locked;        ///< Is the lock taken.
+    std::atomic<unsigned> waiters;   ///< Number of parked threads.
+    unsigned spin_count;             ///< Number of attempts before parking.
+    std::mutex park_mtx;             ///< Mutex used to park the threads.
+    std::condition_variable park_cv; ///< Condition used to wake parked threads.
+};
+
+} // namespace quire
@@ -0,0 +1,100 @@
+/// @file pattern.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Defines the pattern layout, which renders the prefix of each line
+/// following a user-defined pattern.
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <ctime>
+
+#include "quire/quire.hpp"
+
+namespace quire
+{
+
+/// @brief Represents an exception raised by an invalid pattern.
+class pattern_exception_t : public std::runtime_error {
+public:
+    /// @brief Constructs a new pattern exception with a specific error message.
+    /// @param message The error message describing the exception.
+    explicit pattern_exception_t(std::string message)
+        : std::runtime_error(message)
+    {
+        // Nothing to do.
+    }
+};
+
+/// @brief A layout given by a pattern, e.g., "[%T.%ms] %-8L %H {%tid} %loc: %msg".
+/// @details The pattern is compiled once into a list of operations, which
+/// are executed for each line. The fields are:
+///  - %H    the header of the logger;
+///  - %L    the log level;
+///  - %D    the date, as dd/mm/yy;
+///  - %T    the time, as hh:mm:ss;
+///  - %ms   the milliseconds of the time;
+///  - %us   the microseconds of the time;
+///  - %loc  the source location;
+///  - %tid  the name of the thread;
+///  - %ctx  the diagnostic context of the thread;
+///  - %msg  the message, it can only be the last field;
+///  - %%    a percent sign.
+/// A width between the percent sign and the field pads the field with spaces
+/// on the left, e.g., %8L, or on the right if it is negative, e.g., %-16loc.
+class pattern_t {
+public:
+    /// @brief Compiles the pattern.
+    /// @param _pattern The pattern.
+    /// @throws pattern_exception_t if the pattern is not valid.
+    explicit pattern_t(const std::string &_pattern);
+
+    /// @brief Returns the pattern.
+    const std::string &get_pattern() const;
+
+    /// @brief Renders the prefix of a line.
+    /// @param out The output string.
+    /// @param record The record being written.
+    void render(std::string &out, const record_t &record) const;
+
+private:
+    /// @brief The kind of an operation.
+    enum kind_t : std::uint8_t {
+        literal,      ///< Copies a part of the literals.
+        header,       ///< Renders the header.
+        level,        ///< Renders the level.
+        date,         ///< Renders the date.
+        time,         ///< Renders the time.
+        milliseconds, ///< Renders the milliseconds.
+        microseconds, ///< Renders the microseconds.
+        location,     ///< Renders the location.
+        thread,       ///< Renders the name of the thread.
+        context,      ///< Renders the context.
+        message       ///< Marks the start of the message, it is never executed.
+    };
+
+    /// @brief An operation of the compiled pattern.
+    struct op_t {
+        kind_t kind;          ///< The kind of operation.
+        bool left;            ///< The field is padded on the right.
+        std::uint16_t width;  ///< The minimum width of the field.
+        std::uint32_t offset; ///< Offset of the text, within the literals.
+        std::uint32_t length; ///< Length of the text.
+    };
+
+    /// @brief Updates the cached date and time, if the second changed.
+    /// @param seconds The current time, in seconds.
+    void update_clock(std::time_t seconds) const;
+
+    std::string pattern;             ///< The pattern.
+    std::string literals;            ///< The literal text of all operations.
+    std::vector<op_t> ops;           ///< The compiled operations.
+    bool needs_clock;                ///< Some operation shows the time.
+    mutable std::time_t last_second; ///< The second of the cached date and time.
+    mutable char date_text[9];       ///< The cached date.
+    mutable char time_text[9];       ///< The cached time.
+};
+
+} // namespace quire
@@ -5,11 +5,20 @@
 
 #pragma once
 
+#include <unordered_map>
 #include <fstream>
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <thread>
 #include <vector>
 #include <memory>
 #include <mutex>
 
+#include "quire/lock.hpp"
+
 /// @brief Quire source code.
 namespace quire
 {
@@ -68,6 +77,9 @@ extern const char *prevline;  ///< Move cursor to beginning of line, 1 line up.
 } // namespace util
 } // namespace ansi
 
+class sink_t;
+class pattern_t;
+
 /// @brief Defines the log levels.
 enum log_level {
     debug    = 0, ///< Debug level.
@@ -77,87 +89,689 @@ enum log_level {
     critical = 4  ///< Critical level.
 };
 
+class logger_base_t;
+
+// Static keys patch the code of the call sites, they need asm goto, a
+// section per group for COMDAT functions, and sites whose address is a
+// link-time constant, which excludes position-independent code outside
+// executables.
+#if defined(QUIRE_STATIC_KEYS) && defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__)) && \
+    defined(__GNUC__) && !defined(__clang__) && (!defined(__PIC__) || defined(__PIE__))
+#define QUIRE_HAS_STATIC_KEYS 1
+#endif
+
+/// @brief A call site of the logging macros, each one can be enabled or
+/// disabled at runtime, independently from the level of its logger.
+/// @details Sites are static objects initialized at compile time, they join
+/// the site registry the first time they are executed. The state is checked
+/// before formatting the message, so a disabled site costs a single load.
+class site_t {
+public:
+    /// @brief The state of a call site.
+    enum state_t : unsigned char {
+        unregistered = 0, ///< The site was never executed.
+        inherit      = 1, ///< The level of the logger decides.
+        enabled      = 2, ///< The site always logs.
+        disabled     = 3  ///< The site never logs.
+    };
+
+    /// @brief Constructs the site.
+    /// @param _file Source file name.
+    /// @param _line Source line number.
+    /// @param _format Format string of the message.
+    /// @param _level Level of the message, needed only by static keys.
+    constexpr site_t(const char *_file, int _line, const char *_format, log_level _level = debug) noexcept
+        : file(_file),
+          line(_line),
+          format(_format),
+          level(_level),
+          state(unregistered),
+          next(nullptr)
+    {
+        // Nothing to do.
+    }
+
+    /// @brief Checks if the site should log.
+    /// @param logger The logger used by the site.
+    /// @param level The level of the message.
+    /// @return true if the message must be written.
+    inline bool is_enabled(const logger_base_t &logger, log_level level);
+
+    /// @brief Returns the source file name.
+    const char *get_file() const
+    {
+        return file;
+    }
+
+    /// @brief Returns the source line number.
+    int get_line() const
+    {
+        return line;
+    }
+
+    /// @brief Returns the format string of the message.
+    const char *get_format() const
+    {
+        return format;
+    }
+
+    /// @brief Returns the level of the message, only known with static keys.
+    log_level get_level() const
+    {
+        return level;
+    }
+
+    /// @brief Returns the state of the site.
+    state_t get_state() const
+    {
+        return static_cast<state_t>(state.load(std::memory_order_relaxed));
+    }
+
+private:
+    friend class site_registry_t;
+
+    /// @brief Adds the site to the site registry, which sets its state.
+    void attach();
+
+    const char *file;                 ///< Source file name.
+    const int line;                   ///< Source line number.
+    const char *format;               ///< Format string of the message.
+    const log_level level;            ///< Level of the message.
+    std::atomic<unsigned char> state; ///< The state of the site.
+    site_t *next;                     ///< Next site in the site registry.
+};
+
 /// @brief Configuration bitmasks.
 enum class option_t {
     header,
     level,
     location,
     date,
-    time
+    time,
+    context,
+    thread
 };
 
-/// @brief Logger class for managing log entries with configurations and color options.
-class logger_t {
-public:
-    /// @brief Constructs a logger with specified settings for formatting and filtering log entries.
-    /// @param _header Header text included at the start of each log entry.
-    /// @param _min_level Minimum log level required for messages to be logged; messages below this level are ignored.
-    /// @param _separator Character used to separate different components (e.g., timestamp, level, message) in each log entry.
-    /// @param _config Header configuration.
-    explicit logger_t(
-        std::string _header,
-        log_level _min_level,
-        char _separator,
-        const std::vector<option_t> &_config = get_default_configuation()) noexcept;
+/// @brief Information about the record being written, handed to the prefix renderers.
+struct record_t {
+    const std::string &header;   ///< Header of the logger.
+    const std::string &location; ///< Source location, can be empty.
+    log_level level;             ///< Log level of the record.
+    char separator;              ///< Separator character for log components.
+    const std::string &context;  ///< Diagnostic context of the thread, can be empty.
+};
 
-    /// @brief Move constructor.
-    /// @param other The logger instance to move from.
-    logger_t(logger_t &&other) noexcept;
+/// @brief Columns that can be used to build a compile-time layout.
+namespace column
+{
+/// @brief Renders the header of the logger.
+struct header {
+    static void render(std::string &out, const record_t &record);
+};
+/// @brief Renders the log level.
+struct level {
+    static void render(std::string &out, const record_t &record);
+};
+/// @brief Renders the current date.
+struct date {
+    static void render(std::string &out, const record_t &record);
+};
+/// @brief Renders the current time.
+struct time {
+    static void render(std::string &out, const record_t &record);
+};
+/// @brief Renders the source location.
+struct location {
+    static void render(std::string &out, const record_t &record);
+};
+/// @brief Renders the diagnostic context of the thread, see context_guard_t.
+struct context {
+    static void render(std::string &out, const record_t &record);
+};
+/// @brief Renders the name of the thread, see set_thread_name.
+struct thread {
+    static void render(std::string &out, const record_t &record);
+};
+} // namespace column
+
+/// @brief A layout fixed at compile time, the columns are rendered in the
+/// given order without walking a configuration vector.
+/// @tparam Columns The columns, taken from the quire::column namespace.
+template <typename... Columns>
+struct layout_t;
 
+/// @brief The empty layout, it renders nothing.
+template <>
+struct layout_t<> {
+    /// @brief Renders the prefix of a line.
+    static inline void render(std::string &, const record_t &)
+    {
+        // Nothing to do.
+    }
+};
+
+/// @brief Renders the first column, then the remaining ones.
+template <typename Column, typename... Columns>
+struct layout_t<Column, Columns...> {
+    /// @brief Renders the prefix of a line.
+    /// @param out The output string.
+    /// @param record The record being written.
+    static inline void render(std::string &out, const record_t &record)
+    {
+        Column::render(out, record);
+        layout_t<Columns...>::render(out, record);
+    }
+};
+
+/// @brief Common state and output logic shared by all loggers, the way the
+/// prefix of each line is rendered is left to the derived classes.
+class logger_base_t {
+public:
     /// @brief Destructor for cleanup.
-    ~logger_t();
+    virtual ~logger_base_t();
 
     /// @brief Retrieves the current header.
     std::string get_header() const;
 
     /// @brief Retrieves the current log level.
     log_level get_log_level() const;
+
+    /// @brief Checks if messages with the given level are written, without
+    /// taking the lock.
+    /// @param level The log level.
+    /// @return true if the messages are written, false otherwise.
+    inline bool is_enabled(log_level level) const
+    {
+        return level >= min_level.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Logs an already formatted message with location information.
+    /// @param level Log level.
+    /// @param file Source file name, can be null.
+    /// @param line Source line number.
+    /// @param message The message.
+    virtual void log_message(log_level level, char const *file, int line, char const *message) = 0;
+
     /// @brief Resets the log colors to defaults.
     /// @return Reference to the logger instance.
-    logger_t &reset_colors();
+    logger_base_t &reset_colors();
 
-    /// @brief Sets the file handler for log output.
+    /// @brief Sets the file handler for log output, loggers writing to the
+    /// same stream share the same sink.
     /// @param _fstream File handler instance.
     /// @return Reference to the logger instance.
-    logger_t &set_file_handler(std::ostream *_fstream);
+    logger_base_t &set_file_handler(std::ostream *_fstream);
 
-    /// @brief Sets the output stream for log output.
+    /// @brief Sets the output stream for log output, loggers writing to the
+    /// same stream share the same sink.
     /// @param _ostream Output stream.
     /// @return Reference to the logger instance.
-    logger_t &set_output_stream(std::ostream *_ostream);
+    logger_base_t &set_output_stream(std::ostream *_ostream);
+
+    /// @brief Sets the sink receiving the uncolored lines, in place of the file handler.
+    /// @param _sink The sink, can be null.
+    /// @return Reference to the logger instance.
+    logger_base_t &set_file_sink(std::shared_ptr<sink_t> _sink);
+
+    /// @brief Sets the sink receiving the colored lines, in place of the output stream.
+    /// @param _sink The sink, can be null.
+    /// @return Reference to the logger instance.
+    logger_base_t &set_output_sink(std::shared_ptr<sink_t> _sink);
+
+    /// @brief Adds a further sink receiving the uncolored lines.
+    /// @param _sink The sink.
+    /// @return Reference to the logger instance.
+    logger_base_t &add_sink(std::shared_ptr<sink_t> _sink);
+
+    /// @brief Removes a sink previously added with add_sink.
+    /// @param _sink The sink.
+    /// @return Reference to the logger instance.
+    logger_base_t &remove_sink(const std::shared_ptr<sink_t> &_sink);
 
     /// @brief Updates the log header.
     /// @param _header New header string.
     /// @return Reference to the logger instance.
-    logger_t &set_header(std::string _header);
+    logger_base_t &set_header(std::string _header);
 
     /// @brief Sets the log level threshold.
     /// @param _level Minimum log level.
     /// @return Reference to the logger instance.
-    logger_t &set_log_level(log_level _level);
+    logger_base_t &set_log_level(log_level _level);
 
     /// @brief Updates the separator character.
     /// @param _separator New separator character.
     /// @return Reference to the logger instance.
-    logger_t &set_separator(char _separator);
+    logger_base_t &set_separator(char _separator);
 
     /// @brief Assigns colors for a specific log level.
     /// @param level Log level to set colors for.
     /// @param fg Foreground color (default: white).
     /// @param bg Background color (default: reset).
     /// @return Reference to the logger instance.
-    logger_t &set_color(log_level level, const char *fg, const char *bg);
+    logger_base_t &set_color(log_level level, const char *fg, const char *bg);
 
     /// @brief Enables or disables colored output.
     /// @param enable Whether to enable or disable colored output.
     /// @return Reference to the logger instance.
-    logger_t &toggle_color(bool enable);
+    logger_base_t &toggle_color(bool enable);
+
+    /// @brief Sets how long a partial line can wait for its newline, before
+    /// it is written anyway when another line is logged.
+    /// @param _timeout The timeout, zero means that partial lines wait until
+    /// the logger is flushed.
+    /// @return Reference to the logger instance.
+    logger_base_t &set_partial_line_timeout(std::chrono::milliseconds _timeout);
+
+    /// @brief Enables or disables the sanitization of messages: control
+    /// characters, newlines included, are escaped and invalid UTF-8 is
+    /// replaced, so that each message is a single line. Only the newline
+    /// ending the message is kept.
+    /// @param enable Whether to enable or disable the sanitization.
+    /// @return Reference to the logger instance.
+    logger_base_t &toggle_sanitize(bool enable);
+
+    /// @brief Sets the maximum size of a formatted message, longer messages
+    /// are truncated and end with a marker giving their full length.
+    /// @param _size The size, at least 128 bytes, zero means no limit.
+    /// @return Reference to the logger instance.
+    logger_base_t &set_max_message_size(std::size_t _size);
+
+    /// @brief Sets the size the formatting buffer goes back to, after it
+    /// grew beyond it for large messages, and many smaller ones followed.
+    /// @param _size The size, at least 128 bytes, zero means the buffer never shrinks.
+    /// @return Reference to the logger instance.
+    logger_base_t &set_buffer_shrink_size(std::size_t _size);
+
+    void print_logger_state() const;
+
+protected:
+    /// @brief Constructs the shared state of a logger.
+    /// @param _header Header text included at the start of each log entry.
+    /// @param _min_level Minimum log level required for messages to be logged.
+    /// @param _separator Character used to separate different components.
+    logger_base_t(std::string _header, log_level _min_level, char _separator);
+
+    /// @brief Move constructor.
+    /// @param other The logger instance to move from.
+    logger_base_t(logger_base_t &&other) noexcept;
+
+    /// @brief Formats and writes a message, the caller must hold the lock.
+    /// @param level Log level.
+    /// @param file Source file name, can be null.
+    /// @param line Source line number.
+    /// @param format Format string.
+    /// @param args Variable arguments.
+    void write(log_level level, char const *file, int line, char const *format, va_list args);
+
+    /// @brief Writes an already formatted message, the caller must hold the lock.
+    /// @param level Log level.
+    /// @param file Source file name, can be null.
+    /// @param line Source line number.
+    /// @param message The message.
+    void write_message(log_level level, char const *file, int line, char const *message) const;
+
+    /// @brief Renders the information shown before each line.
+    /// @param out The output string.
+    /// @param record The record being written.
+    virtual void render_prefix(std::string &out, const record_t &record) const = 0;
+
+    /// @brief Helper for formatting messages, messages longer than the
+    /// maximum size are truncated, and marked as such.
+    /// @param format Format string.
+    /// @param args Variable arguments.
+    /// @return The message, which is usually held by the buffer.
+    const char *format_message(char const *format, va_list args);
+
+    /// @brief Makes the buffer hold at least the given size.
+    /// @param size The size.
+    /// @return true if the buffer is large enough, false if memory is exhausted.
+    bool reserve_buffer(std::size_t size);
+
+    /// @brief Logs a message by splitting lines and formatting output.
+    /// @param level Log level.
+    /// @param location Source location.
+    /// @param content Message content.
+    void write_log(log_level level, const std::string &location, const char *content) const;
+
+    /// @brief Writes formatted log information, or keeps it aside if the
+    /// line is not complete yet.
+    /// @param level Log level.
+    /// @param location Source location.
+    /// @param line Message content.
+    /// @param length Length of the message.
+    void write_log_line(log_level level, const std::string &location, const char *line, std::size_t length) const;
+
+    /// @brief Writes a complete line to the sinks.
+    /// @param level Log level.
+    /// @param location Source location.
+    /// @param text The line, prefix included.
+    /// @param prefix_length Length of the prefix.
+    void emit_line(log_level level, const std::string &location, const std::string &text, std::size_t prefix_length) const;
+
+    /// @brief Pays the costs of the first log call in advance, the caller
+    /// must hold the lock.
+    /// @param message_size The size of the messages to prepare for.
+    void prepare(std::size_t message_size);
+
+    /// @brief Writes the data as a hexdump, one line for each row, the
+    /// caller must hold the lock.
+    /// @param level Log level.
+    /// @param file Source file name, can be null.
+    /// @param line Source line number.
+    /// @param data The data.
+    /// @param length Length of the data.
+    void write_hexdump(log_level level, char const *file, int line, const void *data, std::size_t length) const;
+
+    /// @brief Begins a record written in chunks, the caller must hold the
+    /// lock until finish_record.
+    /// @param level Log level.
+    /// @param file Source file name, can be null.
+    /// @param line Source line number.
+    void start_record(log_level level, char const *file, int line);
+
+    /// @brief Appends a chunk to the record, the caller must hold the lock.
+    /// @param data The chunk.
+    /// @param length Length of the chunk.
+    void append_record(const char *data, std::size_t length);
+
+    /// @brief Ends the record, the caller must hold the lock.
+    void finish_record();
+
+    /// @brief Writes the partial lines that waited longer than the timeout.
+    void expire_pending_lines() const;
+
+    /// @brief Writes all partial lines, terminating them with a newline,
+    /// the caller must hold the lock.
+    void flush_pending_lines() const;
+
+    /// @brief Flushes the sinks of the logger.
+    void flush_sinks() const;
+
+    /// @brief A line that is still waiting for its newline.
+    struct pending_line_t {
+        std::string content;                         ///< Prefix and fragments so far.
+        std::string location;                        ///< Location of the first fragment.
+        std::size_t prefix_length;                   ///< Length of the prefix.
+        log_level level;                             ///< Level of the first fragment.
+        std::chrono::steady_clock::time_point since; ///< When the first fragment arrived.
+        bool waiting;                                ///< The line is waiting, otherwise the entry is free.
+    };
+
+    /// @brief Partial lines, one per thread, by a token that is never given
+    /// to another thread, unlike std::thread::id. Entries are kept when their
+    /// line is written, so that the next partial line of the thread reuses
+    /// them, and removed when the lines expire or are flushed, so that the
+    /// entries of the threads that exited do not pile up.
+    using pending_map_t = std::unordered_map<std::uint64_t, pending_line_t>;
+
+    /// @brief A sink of the record written in chunks, and if it is colored.
+    using record_sink_t = std::pair<sink_t *, bool>;
+
+    std::shared_ptr<sink_t> output_sink;            ///< Sink receiving colored lines.
+    std::shared_ptr<sink_t> file_sink;              ///< Sink receiving uncolored lines.
+    std::vector<std::shared_ptr<sink_t>> sinks;     ///< Further sinks receiving uncolored lines.
+    std::string header;                             ///< Header for each log entry.
+    std::atomic<log_level> min_level;               ///< Minimum log level threshold.
+    bool enable_color;                              ///< Are colors enabled.
+    char separator;                                 ///< Separator character for log components.
+    char *buffer;                                   ///< Buffer for formatting log messages.
+    std::size_t buffer_length;                      ///< Current buffer size.
+    std::size_t max_message_size;                   ///< Maximum size of a message, zero means no limit.
+    std::size_t buffer_shrink_size;                 ///< Size the buffer shrinks back to, zero means never.
+    std::size_t small_messages;                     ///< Messages in a row that fit in the shrink size.
+    mutable std::string line_buffer;                ///< Buffer for assembling each line.
+    mutable std::string location_buffer;            ///< Buffer for assembling the location.
+    mutable pending_map_t pending_lines;            ///< Partial lines of each thread.
+    mutable std::size_t pending_count;              ///< Partial lines waiting for their newline.
+    std::chrono::milliseconds partial_line_timeout; ///< How long partial lines wait.
+    bool enable_sanitize;                           ///< Are messages sanitized.
+    mutable std::string sanitized;                  ///< Buffer for the sanitized messages.
+    std::string record_location;                    ///< Location of the record written in chunks.
+    std::vector<record_sink_t> record_sinks;        ///< Sinks of the record written in chunks.
+    bool record_newline;                            ///< The record ends with a newline.
+    const char *fg_colors[5];                       ///< Foreground colors for each log level.
+    const char *bg_colors[5];                       ///< Background colors for each log level.
+};
+
+/// @brief Logger whose layout is fixed at compile time.
+/// @tparam Layout The layout, e.g., layout_t<column::header, column::level>.
+/// @tparam Lock The locking policy, e.g., std::mutex, spin_lock_t, or
+/// null_lock_t for loggers used by a single thread.
+template <typename Layout, typename Lock = std::mutex>
+class basic_logger_t : public logger_base_t {
+public:
+    /// @brief The layout used by the logger.
+    using layout_type = Layout;
+    /// @brief The locking policy used by the logger.
+    using lock_type = Lock;
+
+    /// @brief Constructs a logger with specified settings for formatting and filtering log entries.
+    /// @param _header Header text included at the start of each log entry.
+    /// @param _min_level Minimum log level required for messages to be logged; messages below this level are ignored.
+    /// @param _separator Character used to separate different components (e.g., timestamp, level, message) in each log entry.
+    explicit basic_logger_t(std::string _header, log_level _min_level, char _separator)
+        : logger_base_t(std::move(_header), _min_level, _separator),
+          mtx()
+    {
+        // Nothing to do.
+    }
+
+    /// @brief Move constructor.
+    /// @param other The logger instance to move from.
+    basic_logger_t(basic_logger_t &&other) noexcept
+        : logger_base_t(std::move(other)),
+          mtx()
+    {
+        // Nothing to do.
+    }
+
+    /// @brief Logs a message with formatting.
+    /// @param level Log level.
+    /// @param format Format string.
+    void log(log_level level, char const *format, ...)
+    {
+        // Ensure thread safety by locking the mutex.
+        std::lock_guard<Lock> lock(mtx);
+
+        if (this->is_enabled(level)) {
+            va_list args;
+            va_start(args, format);
+            this->write(level, nullptr, 0, format, args);
+            va_end(args);
+        }
+    }
+
+    /// @brief Logs a message with location information.
+    /// @param level Log level.
+    /// @param file Source file name.
+    /// @param line Source line number.
+    /// @param format Format string.
+    void log(log_level level, char const *file, int line, char const *format, ...)
+    {
+        // Ensure thread safety by locking the mutex.
+        std::lock_guard<Lock> lock(mtx);
+
+        if (this->is_enabled(level)) {
+            va_list args;
+            va_start(args, format);
+            this->write(level, file, line, format, args);
+            va_end(args);
+        }
+    }
 
-    /// @brief Configures display options using bitmask settings.
+    /// @brief Logs a message from a call site, which already checked that it is enabled.
+    /// @param site The call site.
+    /// @param level Log level.
+    /// @param format Format string.
+    void log(const site_t &site, log_level level, char const *format, ...)
+    {
+        // Ensure thread safety by locking the mutex.
+        std::lock_guard<Lock> lock(mtx);
+
+        va_list args;
+        va_start(args, format);
+        this->write(level, site.get_file(), site.get_line(), format, args);
+        va_end(args);
+    }
+
+    /// @brief Logs an already formatted message with location information.
+    /// @param level Log level.
+    /// @param file Source file name, can be null.
+    /// @param line Source line number.
+    /// @param message The message.
+    void log_message(log_level level, char const *file, int line, char const *message) override
+    {
+        // Ensure thread safety by locking the mutex.
+        std::lock_guard<Lock> lock(mtx);
+
+        if (this->is_enabled(level)) {
+            this->write_message(level, file, line, message);
+        }
+    }
+
+    /// @brief Logs an already formatted message from a call site, which
+    /// already checked that it is enabled.
+    /// @param site The call site.
+    /// @param level Log level.
+    /// @param message The message.
+    void log_message(const site_t &site, log_level level, char const *message)
+    {
+        // Ensure thread safety by locking the mutex.
+        std::lock_guard<Lock> lock(mtx);
+
+        this->write_message(level, site.get_file(), site.get_line(), message);
+    }
+
+    /// @brief Pays in advance the costs of the first log call: sizes and
+    /// touches the buffers of the logger and of its sinks, loads the time
+    /// zone, primes the clock and the name of the calling thread, and runs
+    /// the formatting code once. Clocks and names are cached per thread,
+    /// so threads that log should call it once too.
+    /// @param message_size The size of the messages to prepare for.
+    void warmup(std::size_t message_size = 1024)
+    {
+        std::lock_guard<Lock> lock(mtx);
+        this->prepare(message_size);
+    }
+
+    /// @brief Logs the data as a hexdump, with the offset, the bytes and
+    /// their printable characters, one line for each row of 16 bytes.
+    /// @param level Log level.
+    /// @param file Source file name, can be null.
+    /// @param line Source line number.
+    /// @param data The data.
+    /// @param length Length of the data.
+    void hexdump(log_level level, char const *file, int line, const void *data, std::size_t length)
+    {
+        // Ensure thread safety by locking the mutex.
+        std::lock_guard<Lock> lock(mtx);
+
+        if (this->is_enabled(level)) {
+            this->write_hexdump(level, file, line, data, length);
+        }
+    }
+
+    /// @brief Begins a record written in chunks: the prefix is rendered
+    /// once, and the chunks go to the sinks without being assembled in the
+    /// logger. The logger and its sinks stay locked until end_record, which
+    /// must be called if this returns true, record_guard_t does it. Until
+    /// then, the thread must not log anything else to the same sinks, e.g.,
+    /// with another logger writing to std::cout, or it deadlocks.
+    /// @param level Log level.
+    /// @param file Source file name, can be null.
+    /// @param line Source line number.
+    /// @return true if the record is written, false if its level is disabled.
+    bool begin_record(log_level level, char const *file = nullptr, int line = 0)
+    {
+        if (!this->is_enabled(level)) {
+            return false;
+        }
+        std::unique_lock<Lock> lock(mtx);
+        this->start_record(level, file, line);
+        // The logger stays locked until end_record.
+        lock.release();
+        return true;
+    }
+
+    /// @brief Appends a chunk to the record, it can contain newlines.
+    /// @param data The chunk.
+    /// @param length Length of the chunk.
+    void append(const char *data, std::size_t length)
+    {
+        this->append_record(data, length);
+    }
+
+    /// @brief Appends a chunk to the record, it can contain newlines.
+    /// @param data The chunk.
+    void append(const std::string &data)
+    {
+        this->append_record(data.data(), data.size());
+    }
+
+    /// @brief Ends the record with a newline, if it has none, and unlocks the logger.
+    void end_record()
+    {
+        std::lock_guard<Lock> lock(mtx, std::adopt_lock);
+        this->finish_record();
+    }
+
+    /// @brief Writes the partial lines still waiting for their newline, and
+    /// flushes the sinks.
+    void flush()
+    {
+        std::lock_guard<Lock> lock(mtx);
+        this->flush_pending_lines();
+        this->flush_sinks();
+    }
+
+protected:
+    /// @brief Renders the prefix using the compile-time layout.
+    /// @param out The output string.
+    /// @param record The record being written.
+    void render_prefix(std::string &out, const record_t &record) const override
+    {
+        Layout::render(out, record);
+    }
+
+private:
+    Lock mtx; ///< Lock for thread safety.
+};
+
+/// @brief Logger class for managing log entries with configurations and color
+/// options, its layout can be changed at runtime.
+class logger_t : public logger_base_t {
+public:
+    /// @brief Constructs a logger with specified settings for formatting and filtering log entries.
+    /// @param _header Header text included at the start of each log entry.
+    /// @param _min_level Minimum log level required for messages to be logged; messages below this level are ignored.
+    /// @param _separator Character used to separate different components (e.g., timestamp, level, message) in each log entry.
+    /// @param _config Header configuration.
+    explicit logger_t(
+        std::string _header,
+        log_level _min_level,
+        char _separator,
+        const std::vector<option_t> &_config = get_default_configuation());
+
+    /// @brief Move constructor.
+    /// @param other The logger instance to move from.
+    logger_t(logger_t &&other) noexcept;
+
+    /// @brief Destructor for cleanup.
+    ~logger_t() override;
+
+    /// @brief Configures display options using bitmask settings, in place
+    /// of the pattern, if any.
     /// @param _config Header configuration.
     /// @return Reference to the logger instance.
     logger_t &configure(const std::vector<option_t> &_config);
 
+    /// @brief Shows the information given by the pattern, in place of the
+    /// configured options, see pattern_t for its syntax.
+    /// @param _pattern The pattern, empty to go back to the configured options.
+    /// @return Reference to the logger instance.
+    /// @throws pattern_exception_t if the pattern is not valid.
+    logger_t &set_pattern(const std::string &_pattern);
+
     /// @brief Logs a message with formatting.
     /// @param level Log level.
     /// @param format Format string.
@@ -170,6 +784,71 @@ public:
     /// @param format Format string.
     void log(log_level level, char const *file, int line, char const *format, ...);
 
+    /// @brief Logs a message from a call site, which already checked that it is enabled.
+    /// @param site The call site.
+    /// @param level Log level.
+    /// @param format Format string.
+    void log(const site_t &site, log_level level, char const *format, ...);
+
+    /// @brief Logs an already formatted message with location information.
+    /// @param level Log level.
+    /// @param file Source file name, can be null.
+    /// @param line Source line number.
+    /// @param message The message.
+    void log_message(log_level level, char const *file, int line, char const *message) override;
+
+    /// @brief Logs an already formatted message from a call site, which
+    /// already checked that it is enabled.
+    /// @param site The call site.
+    /// @param level Log level.
+    /// @param message The message.
+    void log_message(const site_t &site, log_level level, char const *message);
+
+    /// @brief Logs the data as a hexdump, with the offset, the bytes and
+    /// their printable characters, one line for each row of 16 bytes.
+    /// @param level Log level.
+    /// @param file Source file name, can be null.
+    /// @param line Source line number.
+    /// @param data The data.
+    /// @param length Length of the data.
+    void hexdump(log_level level, char const *file, int line, const void *data, std::size_t length);
+
+    /// @brief Pays in advance the costs of the first log call: sizes and
+    /// touches the buffers of the logger and of its sinks, loads the time
+    /// zone, primes the clock and the name of the calling thread, and runs
+    /// the formatting code once. Clocks and names are cached per thread,
+    /// so threads that log should call it once too.
+    /// @param message_size The size of the messages to prepare for.
+    void warmup(std::size_t message_size = 1024);
+
+    /// @brief Begins a record written in chunks: the prefix is rendered
+    /// once, and the chunks go to the sinks without being assembled in the
+    /// logger. The logger and its sinks stay locked until end_record, which
+    /// must be called if this returns true, record_guard_t does it. Until
+    /// then, the thread must not log anything else to the same sinks, e.g.,
+    /// with another logger writing to std::cout, or it deadlocks.
+    /// @param level Log level.
+    /// @param file Source file name, can be null.
+    /// @param line Source line number.
+    /// @return true if the record is written, false if its level is disabled.
+    bool begin_record(log_level level, char const *file = nullptr, int line = 0);
+
+    /// @brief Appends a chunk to the record, it can contain newlines.
+    /// @param data The chunk.
+    /// @param length Length of the chunk.
+    void append(const char *data, std::size_t length);
+
+    /// @brief Appends a chunk to the record, it can contain newlines.
+    /// @param data The chunk.
+    void append(const std::string &data);
+
+    /// @brief Ends the record with a newline, if it has none, and unlocks the logger.
+    void end_record();
+
+    /// @brief Writes the partial lines still waiting for their newline, and
+    /// flushes the sinks.
+    void flush();
+
     void print_logger_state() const;
 
     static inline std::vector<option_t> &get_default_configuation()
@@ -184,44 +863,306 @@ public:
         return configuration;
     }
 
+protected:
+    /// @brief Renders the prefix by walking the runtime configuration.
+    /// @param out The output string.
+    /// @param record The record being written.
+    void render_prefix(std::string &out, const record_t &record) const override;
+
 private:
-    /// @brief Helper for formatting messages.
-    /// @param format Format string.
-    /// @param args Variable arguments.
-    void format_message(char const *format, va_list args);
+    std::mutex mtx;                      ///< Mutex for thread safety.
+    std::vector<option_t> configuration; ///< Configuration of shown information.
+    std::unique_ptr<pattern_t> pattern;  ///< Pattern replacing the configuration, can be null.
+};
 
-    /// @brief Logs a message by splitting lines and formatting output.
+/// @brief Writes a record in chunks with a logger, and ends it when the
+/// guard goes out of scope, even if an exception is thrown in between.
+/// @details The logger and its sinks stay locked while the record is
+/// written, so the thread must not log anything else to the same sinks
+/// until the record ends.
+/// @tparam Logger The logger, a logger_t or a basic_logger_t.
+template <typename Logger>
+class record_guard_t {
+public:
+    /// @brief Begins the record, if its level is enabled.
+    /// @param _logger The logger, it must outlive the guard.
     /// @param level Log level.
-    /// @param location Source location.
-    /// @param content Message content.
-    void write_log(log_level level, const std::string &location, const char *content) const;
+    /// @param file Source file name, can be null.
+    /// @param line Source line number.
+    record_guard_t(Logger &_logger, log_level level, char const *file = nullptr, int line = 0)
+        : logger(_logger),
+          active(_logger.begin_record(level, file, line))
+    {
+        // Nothing to do.
+    }
 
-    /// @brief Writes formatted log information.
-    /// @param level Log level.
-    /// @param location Source location.
-    /// @param line Message content.
-    /// @param length Length of the message.
-    void write_log_line(log_level level, const std::string &location, const char *line, std::size_t length) const;
+    /// @brief Ends the record, if it was not ended already.
+    ~record_guard_t()
+    {
+        // The record is ended even if a sink fails, and we cannot throw here.
+        try {
+            this->end();
+        } catch (...) {
+        }
+    }
+
+    record_guard_t(const record_guard_t &) = delete;
 
-    std::ostream *ostream;                    ///< Output stream for logging.
-    std::ostream *fstream;                    ///< File handler for output.
-    std::mutex mtx;                           ///< Mutex for thread safety.
-    std::string header;                       ///< Header for each log entry.
-    log_level min_level;                      ///< Minimum log level threshold.
-    mutable bool last_log_ended_with_newline; ///< Tracks if last log ended with newline.
-    bool enable_color;                        ///< Are colors enabled.
-    std::vector<option_t> configuration;      ///< Configuration of shown information.
-    char separator;                           ///< Separator character for log components.
-    char *buffer;                             ///< Buffer for formatting log messages.
-    std::size_t buffer_length;                ///< Current buffer size.
-    const char *fg_colors[5];                 ///< Foreground colors for each log level.
-    const char *bg_colors[5];                 ///< Background colors for each log level.
+    record_guard_t &operator=(const record_guard_t &) = delete;
+
+    /// @brief Tells if the record is written, false if its level is disabled.
+    explicit operator bool() const
+    {
+        return active;
+    }
+
+    /// @brief Appends a chunk to the record, it can contain newlines.
+    /// @param data The chunk.
+    /// @param length Length of the chunk.
+    /// @return Reference to the guard.
+    record_guard_t &append(const char *data, std::size_t length)
+    {
+        if (active) {
+            logger.append(data, length);
+        }
+        return *this;
+    }
+
+    /// @brief Appends a chunk to the record, it can contain newlines.
+    /// @param data The chunk.
+    /// @return Reference to the guard.
+    record_guard_t &append(const std::string &data)
+    {
+        return this->append(data.data(), data.size());
+    }
+
+    /// @brief Ends the record, and unlocks the logger and its sinks.
+    void end()
+    {
+        if (active) {
+            active = false;
+            logger.end_record();
+        }
+    }
+
+private:
+    Logger &logger; ///< The logger writing the record.
+    bool active;    ///< The record is being written.
 };
 
+namespace detail
+{
+/// @brief Ends a truncated message with a marker giving its full length.
+/// @param message The message.
+/// @param size Size of the message, terminator included.
+/// @param length Length the message would have had.
+/// @param newline If the marker ends with a newline.
+void mark_truncated(char *message, std::size_t size, std::size_t length, bool newline);
+
+/// @brief Returns the message produced by the callable of a lazy macro.
+inline const char *message_of(const std::string &message)
+{
+    return message.c_str();
+}
+
+/// @brief Returns the message produced by the callable of a lazy macro.
+inline const char *message_of(const char *message)
+{
+    return message;
+}
+} // namespace detail
+
+inline bool site_t::is_enabled(const logger_base_t &logger, log_level level)
+{
+    const unsigned char current = state.load(std::memory_order_relaxed);
+    if (current == inherit) {
+        return logger.is_enabled(level);
+    }
+    if (current == unregistered) {
+        this->attach();
+        return this->is_enabled(logger, level);
+    }
+    return current == enabled;
+}
+
 } // namespace quire
 
-/// @brief Logs the message, with the given level.
-#define qlog(logger, level, ...) logger.log(level, __FILE__, __LINE__, __VA_ARGS__)
+#ifdef QUIRE_HAS_STATIC_KEYS
+
+namespace quire
+{
+namespace detail
+{
+/// @brief An entry of the jump table, one for each call site.
+struct jump_entry_t {
+    std::uintptr_t code;   ///< Address of the patched instruction.
+    std::uintptr_t target; ///< Where the jump goes, when the site is live.
+    site_t *site;          ///< The call site.
+};
+
+/// @brief Adds the jump table of a binary to the site registry, which
+/// patches the sites. Tables are added once, whatever the number of calls.
+/// @param first The first entry.
+/// @param last The end of the table.
+/// @return Always zero.
+int register_jump_table(jump_entry_t *first, jump_entry_t *last);
+
+/// @brief Turns the level into a compile-time constant.
+template <log_level Level>
+struct constant_level_t {
+    static constexpr log_level value = Level; ///< The level.
+};
+} // namespace detail
+} // namespace quire
+
+/// @brief The jump table of this binary, built by the linker.
+extern "C" {
+extern quire::detail::jump_entry_t __start_quire_jump_table[] __attribute__((weak, visibility("hidden")));
+extern quire::detail::jump_entry_t __stop_quire_jump_table[] __attribute__((weak, visibility("hidden")));
+}
+
+namespace quire
+{
+namespace detail
+{
+/// @brief Registers the jump table of the binary including this header.
+__attribute__((used)) static const int jump_table_registration = register_jump_table(__start_quire_jump_table, __stop_quire_jump_table);
+} // namespace detail
+} // namespace quire
+
+#if defined(__x86_64__)
+/// @brief A 5-byte jump to the label, aligned so that it can be patched with
+/// a single store, and its entry in the jump table.
+#define QUIRE_STATIC_BRANCH(site, label)                    \
+    __asm__ goto(".balign 8\n"                              \
+                 "1: .byte 0xe9\n"                          \
+                 ".long %l[" #label "] - 2f\n"              \
+                 "2:\n"                                     \
+                 ".pushsection quire_jump_table, \"aw?\"\n" \
+                 ".balign 8\n"                              \
+                 ".quad 1b, %l[" #label "], %c0\n"          \
+                 ".popsection\n"                            \
+                 :                                          \
+                 : "i"(&(site))                             \
+                 :                                          \
+                 : label)
+#else
+/// @brief A jump to the label, and its entry in the jump table.
+#define QUIRE_STATIC_BRANCH(site, label)                    \
+    __asm__ goto("1: b %l[" #label "]\n"                    \
+                 ".pushsection quire_jump_table, \"aw?\"\n" \
+                 ".balign 8\n"                              \
+                 ".quad 1b, %l[" #label "], %c0\n"          \
+                 ".popsection\n"                            \
+                 :                                          \
+                 : "i"(&(site))                             \
+                 :                                          \
+                 : label)
+#endif
+
+#endif
+
+/// @brief Expands the arguments, needed by the MSVC preprocessor.
+#define QUIRE_EXPAND(x) x
+
+/// @brief Returns the first of the arguments.
+#define QUIRE_FIRST_ARG(...) QUIRE_EXPAND(QUIRE_FIRST_ARG_(__VA_ARGS__, 0))
+
+/// @brief Helper of QUIRE_FIRST_ARG.
+#define QUIRE_FIRST_ARG_(first, ...) first
+
+#ifdef QUIRE_HAS_STATIC_KEYS
+
+/// @brief Logs the message, with the given level, through a call site that
+/// can be enabled or disabled at runtime (see site.hpp). The arguments are
+/// only evaluated if the message is written.
+/// @details The site starts with a jump, which is patched into a NOP while
+/// the site is disabled, or no logger enables its level. The sites must be
+/// initialized at compile time, so the level must be a constant and the
+/// format a string literal.
+#define qlog(logger, level, ...)                                                          \
+    do {                                                                                  \
+        __label__ quire_live;                                                             \
+        static quire::site_t quire_site(__FILE__, __LINE__,                               \
+                                        "" QUIRE_FIRST_ARG(__VA_ARGS__),                  \
+                                        quire::detail::constant_level_t<(level)>::value); \
+        QUIRE_STATIC_BRANCH(quire_site, quire_live);                                      \
+        break;                                                                            \
+    quire_live:                                                                           \
+        if (quire_site.is_enabled((logger), (level))) {                                   \
+            (logger).log(quire_site, (level), __VA_ARGS__);                               \
+        }                                                                                 \
+    } while (0)
+
+/// @brief Logs the message returned by the callable, with the given level,
+/// through a call site like qlog. The callable only runs if the message is
+/// written, it returns a std::string or a null-terminated string. The
+/// callable can contain commas, e.g., a lambda capturing many variables.
+#define qlog_lazy(logger, level, ...)                                                              \
+    do {                                                                                           \
+        __label__ quire_live;                                                                      \
+        static quire::site_t quire_site(__FILE__, __LINE__, #__VA_ARGS__,                          \
+                                        quire::detail::constant_level_t<(level)>::value);          \
+        QUIRE_STATIC_BRANCH(quire_site, quire_live);                                               \
+        break;                                                                                     \
+    quire_live:                                                                                    \
+        if (quire_site.is_enabled((logger), (level))) {                                            \
+            (logger).log_message(quire_site, (level), quire::detail::message_of((__VA_ARGS__)())); \
+        }                                                                                          \
+    } while (0)
+
+/// @brief Logs the data as a hexdump, through a call site like qlog, whose
+/// format is "hexdump".
+#define qhexdump(logger, level, data, length)                                             \
+    do {                                                                                  \
+        __label__ quire_live;                                                             \
+        static quire::site_t quire_site(__FILE__, __LINE__, "hexdump",                    \
+                                        quire::detail::constant_level_t<(level)>::value); \
+        QUIRE_STATIC_BRANCH(quire_site, quire_live);                                      \
+        break;                                                                            \
+    quire_live:                                                                           \
+        if (quire_site.is_enabled((logger), (level))) {                                   \
+            (logger).hexdump((level), __FILE__, __LINE__, (data), (length));              \
+        }                                                                                 \
+    } while (0)
+
+#else
+
+/// @brief Logs the message, with the given level, through a call site that
+/// can be enabled or disabled at runtime (see site.hpp). The arguments are
+/// only evaluated if the message is written.
+/// @details The site keeps the format, so it must be a string literal.
+#define qlog(logger, level, ...)                                                              \
+    do {                                                                                      \
+        static quire::site_t quire_site(__FILE__, __LINE__, "" QUIRE_FIRST_ARG(__VA_ARGS__)); \
+        if (quire_site.is_enabled((logger), (level))) {                                       \
+            (logger).log(quire_site, (level), __VA_ARGS__);                                   \
+        }                                                                                     \
+    } while (0)
+
+/// @brief Logs the message returned by the callable, with the given level,
+/// through a call site like qlog. The callable only runs if the message is
+/// written, it returns a std::string or a null-terminated string. The
+/// callable can contain commas, e.g., a lambda capturing many variables.
+#define qlog_lazy(logger, level, ...)                                                              \
+    do {                                                                                           \
+        static quire::site_t quire_site(__FILE__, __LINE__, #__VA_ARGS__);                         \
+        if (quire_site.is_enabled((logger), (level))) {                                            \
+            (logger).log_message(quire_site, (level), quire::detail::message_of((__VA_ARGS__)())); \
+        }                                                                                          \
+    } while (0)
+
+/// @brief Logs the data as a hexdump, through a call site like qlog, whose
+/// format is "hexdump".
+#define qhexdump(logger, level, data, length)                                \
+    do {                                                                     \
+        static quire::site_t quire_site(__FILE__, __LINE__, "hexdump");      \
+        if (quire_site.is_enabled((logger), (level))) {                      \
+            (logger).hexdump((level), __FILE__, __LINE__, (data), (length)); \
+        }                                                                    \
+    } while (0)
+
+#endif
 
 /// @brief Logs the debug message.
 #define qdebug(logger, ...) qlog(logger, quire::debug, __VA_ARGS__)
@@ -237,3 +1178,19 @@ private:
 
 /// @brief Logs the critical message.
 #define qcritical(logger, ...) qlog(logger, quire::critical, __VA_ARGS__)
+
+/// @brief Logs the debug message returned by the callable, see qlog_lazy.
+#define qdebug_lazy(logger, ...) qlog_lazy(logger, quire::debug, __VA_ARGS__)
+
+/// @brief Logs the info message returned by the callable, see qlog_lazy.
+#define qinfo_lazy(logger, ...) qlog_lazy(logger, quire::info, __VA_ARGS__)
+
+/// @brief Logs the warning message returned by the callable, see qlog_lazy.
+#define qwarning_lazy(logger, ...) qlog_lazy(logger, quire::warning, __VA_ARGS__)
+
+/// @brief Logs the error message returned by the callable, see qlog_lazy.
+#define qerror_lazy(logger, ...) qlog_lazy(logger, quire::error, __VA_ARGS__)
+
+/// @brief Logs the critical message returned by the callable, see qlog_lazy.
+#define qcritical_lazy(logger, ...) qlog_lazy(logger, quire::critical, __VA_ARGS__)
+
@@ -12,6 +12,7 @@
 #include <mutex>
 
 #include "quire/quire.hpp"
+#include "quire/sink.hpp"
 
 namespace quire
 {
@@ -42,6 +43,12 @@ public:
     using iterator = typename map_t::iterator;
     /// @brief An iterator type for constant access to the logger map.
     using const_iterator = typename map_t::const_iterator;
+    /// @brief The type used to share sinks between loggers.
+    using sink_ptr_t = std::shared_ptr<sink_t>;
+    /// @brief The map structure that associates each name with a sink.
+    using sink_map_t = std::unordered_map<std::string, sink_ptr_t>;
+    /// @brief The map structure that associates each stream with its sink.
+    using stream_sink_map_t = std::unordered_map<std::ostream *, std::weak_ptr<sink_t>>;
 
     /// @brief Construct a new registry object.
     explicit registry_t();
@@ -108,6 +115,42 @@ public:
     /// @brief Adjusts the header length for consistent alignment in logs.
     void adjust_header_length();
 
+    /// @brief Adds a named sink to the registry, so that it can be shared by many loggers.
+    /// @param name The name of the sink.
+    /// @param sink The sink.
+    /// @return The sink.
+    sink_ptr_t add_sink(const std::string &name, sink_ptr_t sink);
+
+    /// @brief Retrieves the sink associated with the given name.
+    /// @param name The name of the sink.
+    /// @return The sink, or throws if not found.
+    sink_ptr_t get_sink(const std::string &name) const;
+
+    /// @brief Removes the sink associated with the given name, loggers using
+    /// it keep it alive until they stop using it.
+    /// @param name The name of the sink.
+    void remove_sink(const std::string &name);
+
+    /// @brief Checks if a sink with the specified name exists in the registry.
+    /// @param name The name of the sink.
+    /// @return true if the sink exists; false otherwise.
+    bool contains_sink(const std::string &name) const;
+
+    /// @brief Returns the sink writing to the given stream, creating it if
+    /// needed. Loggers writing to the same stream share the same sink, which
+    /// lives as long as one of them uses it.
+    /// @param stream The output stream.
+    /// @return The sink.
+    sink_ptr_t stream_sink(std::ostream *stream);
+
+    /// @brief Flushes all the named sinks, and the ones bound to streams.
+    void flush_sinks();
+
+    /// @brief Pays in advance the costs of the first log call of every
+    /// logger, and prepares all the sinks, see logger_t::warmup.
+    /// @param message_size The size of the messages to prepare for.
+    void warmup_all(std::size_t message_size = 1024);
+
     /// @brief Retrieves the singleton instance of the registry.
     /// @return A reference to the singleton registry instance.
     static inline registry_t &instance()
@@ -120,6 +163,12 @@ public:
     map_t m_map;
     /// @brief A mutex ensuring thread-safe access to the logger registry.
     std::mutex mtx;
+    /// @brief Stores the mapping between sink names and sinks.
+    sink_map_t m_sinks;
+    /// @brief Stores the mapping between streams and their sinks.
+    stream_sink_map_t m_stream_sinks;
+    /// @brief A mutex ensuring thread-safe access to the sinks.
+    mutable std::mutex sink_mtx;
 };
 
 /// @brief Retrieves a logger by key from the registry.
@@ -153,6 +202,30 @@ inline void remove_logger(registry_t::key_t key)
     registry_t::instance().remove(key);
 }
 
+/// @brief Adds a named sink to the registry.
+/// @param name The name of the sink.
+/// @param sink The sink.
+/// @return The sink.
+inline registry_t::sink_ptr_t add_sink(const std::string &name, registry_t::sink_ptr_t sink)
+{
+    return registry_t::instance().add_sink(name, sink);
+}
+
+/// @brief Retrieves a sink by name from the registry.
+/// @param name The name of the sink.
+/// @return The requested sink.
+inline registry_t::sink_ptr_t get_sink(const std::string &name)
+{
+    return registry_t::instance().get_sink(name);
+}
+
+/// @brief Removes a sink from the registry by name.
+/// @param name The name of the sink.
+inline void remove_sink(const std::string &name)
+{
+    registry_t::instance().remove_sink(name);
+}
+
 /// @brief Returns a const reference to the map of loggers in the registry.
 /// @return const map_t& The map of registered loggers.
 inline const registry_t::map_t &loggers()
@@ -0,0 +1,32 @@
+/// @file sanitize.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Defines the sanitization of messages, which keeps user-controlled
+/// text from forging log lines or terminal escape sequences.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace quire
+{
+
+/// @brief Returns the position of the first byte of the text that must be
+/// rewritten by sanitize, or the length of the text if there is none.
+/// @details Control characters other than the tab, DEL, and every byte
+/// beyond ASCII are reported, the latter must be validated as UTF-8.
+/// @param text The text.
+/// @param length The length of the text.
+/// @return The position of the first byte to rewrite.
+std::size_t find_unsafe(const char *text, std::size_t length);
+
+/// @brief Sanitizes the text: control characters are escaped, e.g., "\n"
+/// or "\x1b", and invalid UTF-8 sequences are replaced by U+FFFD. A single
+/// newline ending the text is kept, it terminates the line.
+/// @param text The text.
+/// @param length The length of the text.
+/// @param out The sanitized text, only written if the text must change.
+/// @return true if the text was rewritten into out, false if it was already safe.
+bool sanitize(const char *text, std::size_t length, std::string &out);
+
+} // namespace quire
@@ -0,0 +1,245 @@
+/// @file sink.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Defines the sinks, the objects loggers write their lines to. A sink
+/// can be shared by many loggers, and has its own lock, buffer and flush policy.
+
+#pragma once
+
+#include <stdexcept>
+#include <ostream>
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <mutex>
+
+#include "quire/quire.hpp"
+
+namespace quire
+{
+
+/// @brief Represents an exception specific to sink operations.
+class sink_exception_t : public std::runtime_error {
+public:
+    /// @brief Constructs a new sink exception with a specific error message.
+    /// @param message The error message describing the exception.
+    explicit sink_exception_t(std::string message)
+        : std::runtime_error(message)
+    {
+        // Nothing to do.
+    }
+};
+
+/// @brief A complete line handed by a logger to its sinks.
+struct line_t {
+    log_level level;           ///< Log level of the line.
+    const char *fg;            ///< Foreground color, null if the line is not colored.
+    const char *bg;            ///< Background color, null if the line is not colored.
+    const char *header;        ///< Header of the logger.
+    const char *location;      ///< Source location, can be empty.
+    const char *text;          ///< The line, prefix included.
+    std::size_t length;        ///< Length of the line.
+    std::size_t prefix_length; ///< Length of the prefix, the message follows it.
+};
+
+/// @brief An entry of the time index of a file sink, the index is a file
+/// containing a sequence of these entries, in native byte order.
+struct time_index_entry_t {
+    std::int64_t time;    ///< When the line was written, in microseconds since the epoch.
+    std::uint64_t offset; ///< Offset of the line inside the log file.
+};
+
+/// @brief Base class of all sinks.
+class sink_t {
+public:
+    /// @brief Constructs a sink that writes and flushes every line.
+    sink_t() noexcept;
+
+    /// @brief Destructor.
+    virtual ~sink_t();
+
+    /// @brief Writes a line, keeping it in the buffer if the flush policy allows it.
+    /// @param line The line to write.
+    void write(const line_t &line);
+
+    /// @brief Writes the content of the buffer and flushes the device.
+    void flush();
+
+    /// @brief Allocates the buffer and touches its memory, so that the first
+    /// lines do not pay for it.
+    void warmup();
+
+    /// @brief Begins a record written in chunks, the sink stays locked
+    /// until end_record is called.
+    /// @param line The record, holding only its prefix so far.
+    void begin_record(const line_t &line);
+
+    /// @brief Appends a chunk to the record. The record is kept in the buffer
+    /// up to the record limit, and written at once by end_record, longer
+    /// records are written as the chunks arrive, and large chunks without
+    /// being copied in the buffer.
+    /// @param data The chunk.
+    /// @param length Length of the chunk.
+    void append_record(const char *data, std::size_t length);
+
+    /// @brief Ends the record, applies the flush policy and unlocks the sink.
+    void end_record();
+
+    /// @brief Sets how many bytes are kept in the buffer before writing them
+    /// to the device, zero means every line is written immediately.
+    /// @param _capacity The capacity of the buffer.
+    /// @return Reference to the sink.
+    sink_t &set_buffer_capacity(std::size_t _capacity);
+
+    /// @brief Sets the level at which lines force a flush of the device.
+    /// @param _level The level.
+    /// @return Reference to the sink.
+    sink_t &set_flush_level(log_level _level);
+
+    /// @brief Sets how long lines can wait in the buffer, checked when the
+    /// next line is written, zero disables the check.
+    /// @param _max_latency The maximum latency.
+    /// @return Reference to the sink.
+    sink_t &set_max_latency(std::chrono::milliseconds _max_latency);
+
+protected:
+    /// @brief Encodes the line and appends it to the buffer, by default the
+    /// line is copied as it is, surrounded by its colors.
+    /// @param out The buffer.
+    /// @param line The line.
+    virtual void append_line(std::string &out, const line_t &line);
+
+    /// @brief Tells if records written in chunks can go to the device as the
+    /// chunks arrive, otherwise they are assembled and then encoded as a
+    /// single line, as sinks writing one message per record must do.
+    /// @return true by default.
+    virtual bool streams_records() const;
+
+    /// @brief Returns how long a record written in chunks can grow in the
+    /// buffer, before it is written to the device as the chunks arrive.
+    /// @return The buffer capacity, and at least 64 KiB, by default.
+    virtual std::size_t record_limit() const;
+
+    /// @brief Writes the data to the underlying device.
+    /// @param data The data.
+    /// @param length Length of the data.
+    virtual void write_device(const char *data, std::size_t length) = 0;
+
+    /// @brief Flushes the underlying device.
+    virtual void flush_device() = 0;
+
+    /// @brief Writes the buffer to the device, the caller must hold the lock.
+    /// @param force_flush Also flush the device.
+    void drain(bool force_flush);
+
+    /// @brief Checks if the lines in the buffer waited longer than the
+    /// maximum latency, the caller must hold the lock.
+    /// @return true if they must be flushed.
+    bool is_late() const;
+
+    std::mutex mtx;                                       ///< Mutex protecting the buffer and the device.
+    std::string buffer;                                   ///< Lines not yet written to the device.
+    std::size_t buffer_capacity;                          ///< Bytes kept before writing to the device.
+    log_level flush_level;                                ///< Lines at or above this level force a flush.
+    std::chrono::milliseconds max_latency;                ///< How long lines can wait in the buffer, zero means no limit.
+    std::chrono::steady_clock::time_point buffered_since; ///< When the first line in the buffer was written.
+    bool dirty;                                           ///< Data was written but the device was not flushed.
+    line_t record;                                        ///< The record being written in chunks.
+    std::string record_text;                              ///< The record being assembled, if it is not streamed.
+    std::size_t record_start;                             ///< Start of the record inside the buffer.
+    bool record_streamed;                                 ///< The record is written as the chunks arrive.
+};
+
+/// @brief A sink writing to an output stream.
+class ostream_sink_t : public sink_t {
+public:
+    /// @brief Constructs the sink.
+    /// @param _stream The output stream, it must outlive the sink, unless
+    /// every line has been flushed before it is destroyed.
+    explicit ostream_sink_t(std::ostream *_stream) noexcept;
+
+    /// @brief Flushes the remaining lines.
+    ~ostream_sink_t() override;
+
+    /// @brief Returns the output stream.
+    std::ostream *get_stream() const;
+
+protected:
+    void write_device(const char *data, std::size_t length) override;
+
+    void flush_device() override;
+
+private:
+    std::ostream *stream; ///< The output stream.
+};
+
+/// @brief A sink appending to a file opened with O_APPEND, that can be shared
+/// by many processes without any cross-process lock.
+/// @details Each write to the file is done with a single write() call, and
+/// never splits a line, as long as the line is shorter than the atomic write
+/// size. The same holds for records written in chunks. Since the file is opened in append mode, the kernel places each
+/// write at the end of the file atomically, so lines written by different
+/// processes never interleave.
+class file_sink_t : public sink_t {
+public:
+    /// @brief Opens the file, creating it if needed.
+    /// @param _path Path of the file.
+    /// @param _atomic_write_size Maximum size of a single write() call.
+    /// @throws sink_exception_t if the file cannot be opened.
+    explicit file_sink_t(const std::string &_path, std::size_t _atomic_write_size = 65536);
+
+    /// @brief Flushes the remaining lines and closes the file.
+    ~file_sink_t() override;
+
+    /// @brief Returns the path of the file.
+    const std::string &get_path() const;
+
+    /// @brief Sets the maximum size of a single write() call, lines longer
+    /// than this are the only ones that can be split across many calls.
+    /// @param _atomic_write_size The size in bytes.
+    /// @return Reference to the sink.
+    file_sink_t &set_atomic_write_size(std::size_t _atomic_write_size);
+
+    /// @brief Enables the sparse time index, written next to the file, in
+    /// `<path>.idx`. An entry maps the time a line was written to its offset
+    /// inside the file, and it is added every `interval` bytes.
+    /// @param interval Bytes between two entries, zero disables the index.
+    /// @return Reference to the sink.
+    /// @throws sink_exception_t if the index cannot be opened.
+    file_sink_t &set_time_index(std::size_t interval = 65536);
+
+protected:
+    void append_line(std::string &out, const line_t &line) override;
+
+    /// @brief Records up to the atomic write size are written with a single
+    /// write() call, like lines.
+    std::size_t record_limit() const override;
+
+    void write_device(const char *data, std::size_t length) override;
+
+    void flush_device() override;
+
+    /// @brief Writes the data with a single write() call, retrying only if
+    /// it was interrupted or partially written.
+    /// @param descriptor The file descriptor.
+    /// @param data The data.
+    /// @param length Length of the data.
+    /// @return true if all the data was written.
+    static bool write_all(int descriptor, const char *data, std::size_t length);
+
+    /// @brief Adds an entry to the index, if the chunk starts far enough from the last one.
+    /// @param time When the first line of the chunk was written.
+    /// @param length Length of the chunk that was just written.
+    void index_chunk(std::int64_t time, std::size_t length);
+
+private:
+    std::string path;                                              ///< Path of the file.
+    int fd;                                                        ///< File descriptor.
+    std::size_t atomic_write_size;                                 ///< Maximum size of a single write() call.
+    int index_fd;                                                  ///< File descriptor of the index, -1 if disabled.
+    std::size_t index_interval;                                    ///< Bytes between two entries of the index.
+    std::uint64_t next_index_offset;                               ///< Offset at which we add the next entry.
+    std::vector<std::pair<std::size_t, std::int64_t> > line_times; ///< Start and time of the buffered lines.
+};
+
+} // namespace quire
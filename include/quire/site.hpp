@@ -0,0 +1,156 @@
+/// @file site.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Defines the site registry, which enables or disables the call
+/// sites of the logging macros at runtime, by file, line range or format.
+/// @details qlog, qlog_lazy, qhexdump and the macros built on them have a
+/// call site, which with QUIRE_STATIC_KEYS starts with a patched jump. Two
+/// macros are exceptions, they have no site and check their logger at
+/// runtime, with a single relaxed load, whether static keys are used or not:
+///  - qlog_s, since it is an expression, and a static key needs a statement;
+///  - qspan, since it declares an object whose lifetime is the scope, and a
+///    jump cannot skip its construction.
+/// The rules of the registry do not apply to them.
+
+#pragma once
+
+#include <climits>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include "quire/quire.hpp"
+
+namespace quire
+{
+
+/// @brief Selects call sites, an empty field matches any site.
+class site_filter_t {
+public:
+    /// @brief Constructs a filter matching every site.
+    site_filter_t();
+
+    /// @brief Matches the sites whose file path ends with the given one.
+    /// @param _file The file path, or its last components.
+    /// @return Reference to the filter.
+    site_filter_t &in_file(const std::string &_file);
+
+    /// @brief Matches the sites within the given lines, inclusive.
+    /// @param _first_line The first line.
+    /// @param _last_line The last line.
+    /// @return Reference to the filter.
+    site_filter_t &in_lines(int _first_line, int _last_line = INT_MAX);
+
+    /// @brief Matches the sites whose format string contains the given text.
+    /// @param _format The text.
+    /// @return Reference to the filter.
+    site_filter_t &with_format(const std::string &_format);
+
+    /// @brief Checks if the filter matches the site.
+    /// @param site The site.
+    /// @return true if it matches.
+    bool matches(const site_t &site) const;
+
+    /// @brief Checks if two filters select the same sites.
+    bool operator==(const site_filter_t &other) const;
+
+private:
+    std::string file;   ///< Suffix of the file path.
+    int first_line;     ///< First line of the range.
+    int last_line;      ///< Last line of the range.
+    std::string format; ///< Text contained in the format string.
+};
+
+/// @brief Keeps track of the call sites, and of the rules setting their state.
+/// @details Rules are kept in order, and applied to the sites that are
+/// already registered, and to the ones that register later, the last
+/// matching rule wins.
+class site_registry_t {
+public:
+    /// @brief Sets the state of the matching sites.
+    /// @param filter Selects the sites.
+    /// @param state The new state.
+    /// @return The number of registered sites that matched.
+    std::size_t set_state(const site_filter_t &filter, site_t::state_t state);
+
+    /// @brief Returns the registered sites.
+    std::vector<const site_t *> get_sites() const;
+
+    /// @brief Adds the site to the registry, and sets its state.
+    /// @param site The site.
+    void attach(site_t &site);
+
+#ifdef QUIRE_HAS_STATIC_KEYS
+    /// @brief Adds a jump table, attaches its sites and patches them.
+    /// @param first The first entry.
+    /// @param last The end of the table.
+    void add_jump_table(detail::jump_entry_t *first, detail::jump_entry_t *last);
+
+    /// @brief Records that a logger enables the given level, and the ones above it.
+    /// @param level The minimum level of the logger.
+    void retain_level(log_level level);
+
+    /// @brief Records that a logger no longer enables the given level, and the ones above it.
+    /// @param level The minimum level of the logger.
+    void release_level(log_level level);
+#endif
+
+    /// @brief Retrieves the singleton instance of the site registry.
+    /// @details The registry is never destroyed, since sites and loggers can
+    /// use it until the very end of the program.
+    /// @return A reference to the singleton site registry instance.
+    static inline site_registry_t &instance()
+    {
+        static site_registry_t *registry = new site_registry_t();
+        return *registry;
+    }
+
+private:
+    /// @brief Construct a new site registry object.
+    site_registry_t();
+
+#ifdef QUIRE_HAS_STATIC_KEYS
+    /// @brief Patches the sites of all the jump tables, so that a site jumps
+    /// to its check only if it is enabled, or some logger enables its level.
+    /// The caller must hold the lock.
+    void patch_sites();
+#endif
+
+    /// @brief The rules, in the order they were added.
+    std::vector<std::pair<site_filter_t, site_t::state_t> > rules;
+    /// @brief The first registered site, the others are linked to it.
+    site_t *head;
+    /// @brief A mutex ensuring thread-safe access to the registry.
+    mutable std::mutex mtx;
+#ifdef QUIRE_HAS_STATIC_KEYS
+    /// @brief The jump tables, one per binary.
+    std::vector<std::pair<detail::jump_entry_t *, detail::jump_entry_t *> > jump_tables;
+    /// @brief For each level, the number of loggers enabling it.
+    std::size_t level_refs[5];
+#endif
+};
+
+/// @brief Makes the matching sites always log, whatever the level of their logger.
+/// @param filter Selects the sites.
+/// @return The number of registered sites that matched.
+inline std::size_t enable_sites(const site_filter_t &filter)
+{
+    return site_registry_t::instance().set_state(filter, site_t::enabled);
+}
+
+/// @brief Makes the matching sites never log.
+/// @param filter Selects the sites.
+/// @return The number of registered sites that matched.
+inline std::size_t disable_sites(const site_filter_t &filter)
+{
+    return site_registry_t::instance().set_state(filter, site_t::disabled);
+}
+
+/// @brief Lets the level of their logger decide again, for the matching sites.
+/// @param filter Selects the sites.
+/// @return The number of registered sites that matched.
+inline std::size_t reset_sites(const site_filter_t &filter = site_filter_t())
+{
+    return site_registry_t::instance().set_state(filter, site_t::inherit);
+}
+
+} // namespace quire
@@ -0,0 +1,113 @@
+/// @file socket_sink.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Defines a sink shipping lines to a local collector over a stream socket.
+
+#pragma once
+
+#include "quire/sink.hpp"
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__unix__)
+
+#include <atomic>
+#include <chrono>
+
+namespace quire
+{
+
+/// @brief A sink sending lines to a log collector, over a UNIX or a TCP
+/// stream socket.
+/// @details Lines are coalesced in the buffer of the sink, and sent with few
+/// large writes. The socket is non-blocking: what the collector does not
+/// accept is kept in a bounded outgoing buffer, and sent at the next write or
+/// flush; what does not fit is dropped, and counted. When the connection is
+/// lost the sink reconnects, waiting longer after each failed attempt, and
+/// never waits for the connection to be established.
+/// By default errors, and the lines above them, are sent at once, the other
+/// lines are sent when 64 KiB build up, or when a line is written at least
+/// 100 ms after the oldest one in the buffer. A process that stops logging
+/// keeps its last lines until the next flush, they are lost if it crashes.
+class socket_sink_t : public sink_t {
+public:
+    /// @brief Creates a sink connecting to a UNIX stream socket.
+    /// @param _path Path of the socket.
+    explicit socket_sink_t(const std::string &_path);
+
+    /// @brief Creates a sink connecting to a TCP socket.
+    /// @param _address Numeric IPv4 address, usually the loopback one.
+    /// @param _port The port.
+    /// @throws sink_exception_t if the address is not valid.
+    socket_sink_t(const std::string &_address, unsigned short _port);
+
+    /// @brief Tries to send the remaining lines, and closes the socket.
+    ~socket_sink_t() override;
+
+    /// @brief Returns true if the sink is connected to the collector.
+    bool is_connected() const;
+
+    /// @brief Returns the number of bytes that could not be delivered.
+    std::size_t get_dropped() const;
+
+    /// @brief Returns the number of bytes waiting to be sent.
+    std::size_t get_pending_size() const;
+
+    /// @brief Sets how many bytes can wait to be sent, before dropping lines.
+    /// @param _max_pending_size The size in bytes.
+    /// @return Reference to the sink.
+    socket_sink_t &set_max_pending_size(std::size_t _max_pending_size);
+
+    /// @brief Sets how long to wait before reconnecting, the delay doubles
+    /// after each failed attempt, up to the maximum.
+    /// @param _min_backoff Delay after the first failure.
+    /// @param _max_backoff Maximum delay.
+    /// @return Reference to the sink.
+    socket_sink_t &set_reconnect_backoff(std::chrono::milliseconds _min_backoff, std::chrono::milliseconds _max_backoff);
+
+protected:
+    /// @brief Records are sent whole, those longer than the outgoing buffer
+    /// are dropped, like lines of that size.
+    std::size_t record_limit() const override;
+
+    void write_device(const char *data, std::size_t length) override;
+
+    void flush_device() override;
+
+    /// @brief Starts connecting, if the backoff allows it, or checks if the
+    /// connection being established is ready.
+    /// @return true if the sink is connected.
+    bool connect();
+
+    /// @brief Closes the socket, and schedules the next attempt.
+    void disconnect();
+
+    /// @brief Sends the pending data, as long as the collector accepts it.
+    void send_pending();
+
+private:
+    /// @brief State of the connection.
+    enum class state_t {
+        disconnected, ///< No socket.
+        connecting,   ///< The connection is being established.
+        connected     ///< The connection is established.
+    };
+
+    int domain;                                         ///< AF_UNIX or AF_INET.
+    std::string path;                                   ///< Path of the UNIX socket.
+    std::string address;                                ///< Address of the TCP socket.
+    unsigned short port;                                ///< Port of the TCP socket.
+    int fd;                                             ///< The socket.
+    std::atomic<state_t> state;                         ///< State of the connection.
+    std::string pending;                                ///< Data not yet sent.
+    std::size_t pending_start;                          ///< Start of the data not yet sent.
+    bool torn;                                          ///< The last line was sent in part.
+    std::size_t max_pending_size;                       ///< Maximum size of the data not yet sent.
+    std::atomic<std::size_t> pending_size;              ///< Bytes waiting to be sent.
+    std::atomic<std::size_t> dropped;                   ///< Bytes that could not be delivered.
+    std::chrono::milliseconds min_backoff;              ///< Delay after the first failure.
+    std::chrono::milliseconds max_backoff;              ///< Maximum delay between attempts.
+    std::chrono::milliseconds backoff;                  ///< Delay after the next failure.
+    std::chrono::steady_clock::time_point next_attempt; ///< When we can try to connect again.
+};
+
+} // namespace quire
+
+#endif
@@ -0,0 +1,176 @@
+/// @file span.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Defines scoped spans, which measure how long a scope takes, and
+/// the tracer writing them as Chrome trace events.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "quire/quire.hpp"
+
+namespace quire
+{
+
+namespace detail
+{
+struct span_buffer_t;
+} // namespace detail
+
+/// @brief A span recorded by a thread, waiting to be written to the trace.
+struct span_event_t {
+    const char *name;   ///< Name of the span, it must outlive the trace.
+    std::int64_t begin; ///< When the span began, in nanoseconds of the monotonic clock.
+    std::int64_t end;   ///< When the span ended, in nanoseconds of the monotonic clock.
+};
+
+/// @brief Collects the spans of all threads, and writes them to a sink as
+/// Chrome trace events, that can be loaded in chrome://tracing or Perfetto.
+/// @details Each thread records its spans in its own buffer, allocated with
+/// its first span; a full buffer is written by the thread that filled it,
+/// the other ones when the trace is flushed or stopped.
+class tracer_t {
+public:
+    /// @brief Number of spans kept by each thread, before writing them.
+    static const std::size_t buffer_capacity = 1024;
+
+    /// @brief Starts a new trace, written to the given sink, usually a file sink.
+    /// @param _sink The sink.
+    void start(std::shared_ptr<sink_t> _sink);
+
+    /// @brief Writes the remaining spans, and ends the trace.
+    void stop();
+
+    /// @brief Writes the spans recorded so far by all threads.
+    void flush();
+
+    /// @brief Returns true if a trace is being recorded.
+    bool is_tracing() const
+    {
+        return tracing.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Records a span in the buffer of the calling thread.
+    /// @param name Name of the span.
+    /// @param begin When the span began.
+    /// @param end When the span ended.
+    void record(const char *name, std::int64_t begin, std::int64_t end);
+
+    /// @brief Retrieves the singleton instance of the tracer.
+    /// @details The tracer is never destroyed, since threads can record
+    /// spans until the very end of the program.
+    /// @return A reference to the singleton tracer instance.
+    static inline tracer_t &instance()
+    {
+        static tracer_t *tracer = new tracer_t();
+        return *tracer;
+    }
+
+private:
+    friend struct detail::span_buffer_t;
+
+    /// @brief Construct a new tracer object.
+    tracer_t();
+
+    /// @brief Adds the buffer of a new thread.
+    void attach(detail::span_buffer_t *buffer);
+
+    /// @brief Writes the spans of a thread that is exiting, and removes its buffer.
+    void detach(detail::span_buffer_t *buffer);
+
+    /// @brief Writes the spans of the buffer to the sink, the caller must hold the lock.
+    void write_buffer(detail::span_buffer_t &buffer);
+
+    /// @brief Writes the text to the sink, the caller must hold the lock.
+    void write_text(const std::string &text);
+
+    std::mutex mtx;                               ///< Mutex protecting the sink and the buffers.
+    std::shared_ptr<sink_t> sink;                 ///< The sink of the trace.
+    std::atomic<bool> tracing;                    ///< A trace is being recorded.
+    bool first_event;                             ///< No event was written to the trace yet.
+    std::vector<detail::span_buffer_t *> buffers; ///< The buffers of the threads.
+    unsigned next_tid;                            ///< Identifier of the next thread.
+    long pid;                                     ///< Identifier of the process.
+    std::string json;                             ///< The events being written.
+};
+
+/// @brief Measures the time spent in a scope. While a trace is being
+/// recorded the span is added to it, otherwise it is logged as a debug line.
+class span_t {
+public:
+    /// @brief Begins the span.
+    /// @param _logger The logger writing the span, when not tracing.
+    /// @param _name Name of the span, it must outlive the trace.
+    /// @param _file Source file name.
+    /// @param _line Source line number.
+    span_t(logger_base_t &_logger, const char *_name, const char *_file, int _line) noexcept
+        : logger(_logger),
+          name(_name),
+          file(_file),
+          line(_line),
+          begin(0),
+          mode(tracer_t::instance().is_tracing() ? trace : (_logger.is_enabled(debug) ? log : none))
+    {
+        // We read the clock only if the span goes somewhere.
+        if (mode != none) {
+            begin = span_t::now();
+        }
+    }
+
+    /// @brief Ends the span, the span is dropped if it cannot be recorded.
+    ~span_t()
+    {
+        // The buffer of the thread, or a sink, can throw, and we cannot throw here.
+        if (mode != none) {
+            try {
+                this->finish(span_t::now());
+            } catch (...) {
+            }
+        }
+    }
+
+    span_t(const span_t &)            = delete;
+    span_t &operator=(const span_t &) = delete;
+
+    /// @brief Returns the time of the monotonic clock, in nanoseconds.
+    static inline std::int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    /// @brief Where the span goes.
+    enum mode_t : unsigned char {
+        none,  ///< Nowhere.
+        trace, ///< To the trace.
+        log    ///< To the logger.
+    };
+
+    /// @brief Records, or logs, the span.
+    /// @param end When the span ended.
+    void finish(std::int64_t end);
+
+    logger_base_t &logger; ///< The logger writing the span, when not tracing.
+    const char *name;      ///< Name of the span.
+    const char *file;      ///< Source file name.
+    int line;              ///< Source line number.
+    std::int64_t begin;    ///< When the span began.
+    mode_t mode;           ///< Where the span goes.
+};
+
+} // namespace quire
+
+/// @brief Concatenates the two tokens, after expanding them.
+#define QUIRE_CONCAT(a, b) QUIRE_CONCAT_(a, b)
+
+/// @brief Helper of QUIRE_CONCAT.
+#define QUIRE_CONCAT_(a, b) a##b
+
+/// @brief Measures the time spent in the rest of the scope.
+#define qspan(logger, name) quire::span_t QUIRE_CONCAT(quire_span_, __LINE__)((logger), (name), __FILE__, __LINE__)
@@ -0,0 +1,123 @@
+/// @file stream.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Stream-style logging, for types providing an operator<<.
+
+#pragma once
+
+#include <streambuf>
+#include <ostream>
+
+#include "quire/quire.hpp"
+
+#ifndef QUIRE_STREAM_BUFFER_SIZE
+/// @brief Capacity of the buffer used by the stream-style logging, longer
+/// messages are truncated, and end with a marker giving their length.
+#define QUIRE_STREAM_BUFFER_SIZE 4096
+#endif
+
+namespace quire
+{
+
+namespace detail
+{
+
+/// @brief A stream buffer with a fixed capacity, it never allocates.
+class fixed_streambuf_t : public std::streambuf {
+public:
+    /// @brief Constructs an empty buffer.
+    fixed_streambuf_t() noexcept;
+
+    /// @brief Empties the buffer.
+    void reset() noexcept;
+
+    /// @brief Terminates the content, appending a newline if missing, and
+    /// the truncation marker if the content did not fit.
+    /// @return The content of the buffer.
+    const char *terminate() noexcept;
+
+protected:
+    /// @brief Counts the characters that do not fit, instead of failing.
+    int_type overflow(int_type ch) override;
+
+    /// @brief Copies what fits, and counts the rest.
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+
+private:
+    /// @brief Storage, with room for the newline and the terminator.
+    char data[QUIRE_STREAM_BUFFER_SIZE + 2];
+    /// @brief Characters that did not fit in the buffer.
+    std::size_t dropped;
+};
+
+/// @brief The buffer and the stream writing into it, reused by each thread.
+struct stream_slot_t {
+    /// @brief Constructs the slot.
+    stream_slot_t();
+
+    fixed_streambuf_t buffer; ///< The buffer.
+    std::ostream stream;      ///< The stream writing into the buffer.
+};
+
+/// @brief Used to turn the stream expression into a void expression, in the
+/// macros. It has lower precedence than operator<<, and higher than ?:.
+struct stream_voidify_t {
+    /// @brief Discards the stream.
+    void operator&(std::ostream &)
+    {
+        // Nothing to do.
+    }
+};
+
+} // namespace detail
+
+/// @brief A record built with operator<<, it is written to the logger when
+/// the object is destroyed, at the end of the full expression.
+class record_stream_t {
+public:
+    /// @brief Starts a record, using the buffer of the calling thread.
+    /// @param _logger The logger.
+    /// @param _level The log level.
+    /// @param _file Source file name.
+    /// @param _line Source line number.
+    record_stream_t(logger_base_t &_logger, log_level _level, const char *_file, int _line);
+
+    /// @brief Writes the record to the logger, the record is dropped if the
+    /// logger throws.
+    ~record_stream_t();
+
+    /// @brief Returns the stream building the record.
+    std::ostream &stream();
+
+private:
+    record_stream_t(const record_stream_t &)            = delete;
+    record_stream_t &operator=(const record_stream_t &) = delete;
+
+    detail::stream_slot_t *slot; ///< The buffer and the stream.
+    logger_base_t &logger;       ///< The logger.
+    log_level level;             ///< The log level.
+    const char *file;            ///< Source file name.
+    int line;                    ///< Source line number.
+};
+
+} // namespace quire
+
+/// @brief Logs the message built with operator<<, with the given level. When
+/// the level is disabled, nothing is constructed and nothing is evaluated.
+#define qlog_s(logger, level)                           \
+    !(logger).is_enabled(level) ? static_cast<void>(0) : \
+                                  quire::detail::stream_voidify_t() & quire::record_stream_t((logger), (level), __FILE__, __LINE__).stream()
+
+/// @brief Logs the debug message built with operator<<.
+#define qdebug_s(logger) qlog_s(logger, quire::debug)
+
+/// @brief Logs the info message built with operator<<.
+#define qinfo_s(logger) qlog_s(logger, quire::info)
+
+/// @brief Logs the warning message built with operator<<.
+#define qwarning_s(logger) qlog_s(logger, quire::warning)
+
+/// @brief Logs the error message built with operator<<.
+#define qerror_s(logger) qlog_s(logger, quire::error)
+
+/// @brief Logs the critical message built with operator<<.
+#define qcritical_s(logger) qlog_s(logger, quire::critical)
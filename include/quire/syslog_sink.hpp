@@ -0,0 +1,102 @@
+/// @file syslog_sink.hpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Defines a sink sending RFC 5424 records to the local syslog daemon.
+
+#pragma once
+
+#include "quire/sink.hpp"
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__unix__)
+
+#include <atomic>
+#include <vector>
+
+namespace quire
+{
+
+/// @brief A sink formatting each line as an RFC 5424 record, and sending it
+/// to the syslog daemon through a local UNIX datagram socket.
+/// @details The PRI is computed from the facility and the level, the
+/// APP-NAME is the header of the logger. The socket is non-blocking: when the
+/// daemon is slow, the records are kept in a bounded backlog and sent with
+/// the following ones, and they are dropped only when the backlog is full.
+class syslog_sink_t : public sink_t {
+public:
+    /// @brief Opens the socket.
+    /// @param _socket_path Path of the socket of the daemon, it can point to
+    /// a local stand-in, for testing.
+    /// @param _facility The syslog facility, user-level messages by default.
+    /// @throws sink_exception_t if the socket cannot be created.
+    explicit syslog_sink_t(const std::string &_socket_path = "/dev/log", int _facility = 1);
+
+    /// @brief Tries to send the remaining records, and closes the socket.
+    ~syslog_sink_t() override;
+
+    /// @brief Returns the path of the socket of the daemon.
+    const std::string &get_socket_path() const;
+
+    /// @brief Returns the number of records that could not be delivered.
+    std::size_t get_dropped() const;
+
+    /// @brief Returns the number of bytes waiting in the backlog.
+    std::size_t get_backlog_size() const;
+
+    /// @brief Sets how many bytes can wait for the daemon, before dropping records.
+    /// @param _max_backlog_size The size in bytes.
+    /// @return Reference to the sink.
+    syslog_sink_t &set_max_backlog_size(std::size_t _max_backlog_size);
+
+    /// @brief Sets the maximum size of a record, longer ones are truncated.
+    /// @param _max_record_size The size in bytes.
+    /// @return Reference to the sink.
+    syslog_sink_t &set_max_record_size(std::size_t _max_record_size);
+
+protected:
+    void append_line(std::string &out, const line_t &line) override;
+
+    bool streams_records() const override;
+
+    void write_device(const char *data, std::size_t length) override;
+
+    void flush_device() override;
+
+    /// @brief Outcome of sending a record.
+    enum class send_result_t {
+        sent,        ///< The record was sent.
+        would_block, ///< The daemon is slow, try again later.
+        failed       ///< The record cannot be delivered.
+    };
+
+    /// @brief Sends a single record, without blocking.
+    /// @param data The record.
+    /// @param length Length of the record.
+    /// @return The outcome.
+    send_result_t send_record(const char *data, std::size_t length);
+
+    /// @brief Sends the records waiting in the backlog, as long as the daemon accepts them.
+    void drain_backlog();
+
+    /// @brief Appends a record to the backlog, or drops it if the backlog is full.
+    /// @param data The record.
+    /// @param length Length of the record.
+    void enqueue(const char *data, std::size_t length);
+
+private:
+    std::string socket_path;               ///< Path of the socket of the daemon.
+    int fd;                                ///< The socket.
+    int facility;                          ///< The syslog facility.
+    std::string hostname;                  ///< The HOSTNAME field.
+    std::string procid;                    ///< The PROCID field.
+    std::size_t max_record_size;           ///< Records are truncated to this size.
+    std::vector<std::size_t> entry_ends;   ///< End of each record inside the buffer.
+    std::string backlog;                   ///< Records refused by the daemon.
+    std::vector<std::size_t> backlog_ends; ///< End of each record inside the backlog.
+    std::size_t backlog_start;             ///< Start of the first record in the backlog.
+    std::size_t max_backlog_size;          ///< Maximum size of the backlog.
+    std::atomic<std::size_t> backlog_size; ///< Bytes waiting in the backlog.
+    std::atomic<std::size_t> dropped;      ///< Records that could not be delivered.
+};
+
+} // namespace quire
+
+#endif
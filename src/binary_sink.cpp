@@ -0,0 +1,313 @@
+/// @file binary_sink.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include "quire/binary_sink.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace quire
+{
+
+namespace binary
+{
+
+const char magic[4] = { 'Q', 'R', '\xC5', '\x1A' };
+
+const char sync_marker[sync_size] = { '\xFE', 'Q', 'U', 'I', 'R', 'E', '-', 'S', 'Y', 'N', 'C', '\xFE', '\x00', '\x5A', '\xA5', '\xFF' };
+
+/// @brief Builds the lookup table of the CRC-32C, once.
+static inline const std::uint32_t *__crc32c_table()
+{
+    static const struct table_t {
+        std::uint32_t entries[256];
+        table_t()
+        {
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                std::uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc & 1U) ? ((crc >> 1U) ^ 0x82F63B78U) : (crc >> 1U);
+                }
+                entries[i] = crc;
+            }
+        }
+    } table;
+    return table.entries;
+}
+
+/// @brief Appends a little-endian number.
+template <typename T>
+static inline void __append_le(std::string &out, T value, std::size_t bytes)
+{
+    for (std::size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((static_cast<std::uint64_t>(value) >> (8U * i)) & 0xFFU));
+    }
+}
+
+/// @brief Reads a little-endian number.
+static inline std::uint64_t __read_le(const char *data, std::size_t bytes)
+{
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i])) << (8U * i);
+    }
+    return value;
+}
+
+std::uint32_t crc32c(const void *data, std::size_t length, std::uint32_t crc)
+{
+    const std::uint32_t *table = __crc32c_table();
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    crc                        = ~crc;
+    for (std::size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xFFU] ^ (crc >> 8U);
+    }
+    return ~crc;
+}
+
+decode_result_t decode(const char *data, std::size_t length, record_view_t &record, std::size_t &size)
+{
+    // == SYNC POINT ==========================================================
+    if (std::memcmp(data, sync_marker, std::min(length, sync_size)) == 0) {
+        if (length < sync_size) {
+            return decode_result_t::incomplete;
+        }
+        size = sync_size;
+        return decode_result_t::sync;
+    }
+    // == FRAME ===============================================================
+    if (std::memcmp(data, magic, std::min<std::size_t>(length, 4)) != 0) {
+        return decode_result_t::corrupt;
+    }
+    if (length < frame_size) {
+        return decode_result_t::incomplete;
+    }
+    const std::size_t payload_size = static_cast<std::size_t>(__read_le(data + 4, 4));
+    if ((payload_size < payload_header_size) || (payload_size > max_payload_size)) {
+        return decode_result_t::corrupt;
+    }
+    if (length < (frame_size + payload_size)) {
+        return decode_result_t::incomplete;
+    }
+    const std::uint32_t checksum = crc32c(data + frame_size, payload_size, crc32c(data + 4, 4));
+    if (checksum != static_cast<std::uint32_t>(__read_le(data + 8, 4))) {
+        return decode_result_t::corrupt;
+    }
+    // == PAYLOAD =============================================================
+    const char *payload   = data + frame_size;
+    record.time           = static_cast<std::int64_t>(__read_le(payload, 8));
+    const unsigned level  = static_cast<unsigned char>(payload[8]);
+    record.header_len     = static_cast<std::size_t>(__read_le(payload + 9, 2));
+    record.location_len   = static_cast<std::size_t>(__read_le(payload + 11, 2));
+    if ((level > critical) || ((payload_header_size + record.header_len + record.location_len) > payload_size)) {
+        return decode_result_t::corrupt;
+    }
+    record.level       = static_cast<log_level>(level);
+    record.header      = payload + payload_header_size;
+    record.location    = record.header + record.header_len;
+    record.message     = record.location + record.location_len;
+    record.message_len = payload_size - payload_header_size - record.header_len - record.location_len;
+    size               = frame_size + payload_size;
+    return decode_result_t::record;
+}
+
+std::size_t find_sync(const char *data, std::size_t length, std::size_t offset)
+{
+    record_view_t record;
+    std::size_t size;
+    while ((offset + sync_size) <= length) {
+        const void *candidate = std::memchr(data + offset, sync_marker[0], length - offset - sync_size + 1);
+        if (candidate == nullptr) {
+            break;
+        }
+        offset = static_cast<std::size_t>(static_cast<const char *>(candidate) - data);
+        if (std::memcmp(data + offset, sync_marker, sync_size) == 0) {
+            // The marker could be part of a message, check what follows it.
+            const std::size_t next = offset + sync_size;
+            if ((next == length) || (decode(data + next, length - next, record, size) != decode_result_t::corrupt)) {
+                return offset;
+            }
+        }
+        ++offset;
+    }
+    return length;
+}
+
+std::size_t find_record(const char *data, std::size_t length, std::size_t offset)
+{
+    record_view_t record;
+    std::size_t size;
+    // A record cut by the end of the data is only trusted if nothing valid follows it.
+    std::size_t incomplete = length;
+    for (; offset < length; ++offset) {
+        if ((data[offset] != magic[0]) && (data[offset] != sync_marker[0])) {
+            continue;
+        }
+        const decode_result_t result = decode(data + offset, length - offset, record, size);
+        if ((result == decode_result_t::record) || (result == decode_result_t::sync)) {
+            return offset;
+        }
+        if ((result == decode_result_t::incomplete) && (incomplete == length)) {
+            incomplete = offset;
+        }
+    }
+    return incomplete;
+}
+
+} // namespace binary
+
+/// @brief Writes the data, retrying only if interrupted or partially written.
+/// @return true if all the data was written.
+static inline bool __write_all(int fd, const char *data, std::size_t length)
+{
+    while (length > 0) {
+#ifdef _WIN32
+        const long written = ::_write(fd, data, static_cast<unsigned>(length));
+#else
+        const long written = static_cast<long>(::write(fd, data, length));
+#endif
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Logging must never stop the caller, we drop the data.
+            return false;
+        }
+        data += written;
+        length -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+binary_sink_t::binary_sink_t(const std::string &_path, std::size_t _sync_interval, std::size_t _atomic_write_size)
+    : sink_t(),
+      path(_path),
+      fd(-1),
+      sync_interval(_sync_interval),
+      atomic_write_size(_atomic_write_size > 0 ? _atomic_write_size : 1),
+      since_sync(_sync_interval),
+      record_ends(),
+      chunk()
+{
+#ifdef _WIN32
+    fd = ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+    if (fd < 0) {
+        throw quire::sink_exception_t("Failed to open `" + path + "`: " + std::strerror(errno));
+    }
+}
+
+binary_sink_t::~binary_sink_t()
+{
+    this->flush();
+#ifdef _WIN32
+    ::_close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+const std::string &binary_sink_t::get_path() const
+{
+    return path;
+}
+
+bool binary_sink_t::streams_records() const
+{
+    // Each record is a single message, it must be encoded as a whole.
+    return false;
+}
+
+void binary_sink_t::append_line(std::string &out, const line_t &line)
+{
+    const std::size_t start = out.size();
+
+    const std::size_t header_len   = std::min<std::size_t>(std::strlen(line.header), 0xFFFFU);
+    const std::size_t location_len = std::min<std::size_t>(std::strlen(line.location), 0xFFFFU);
+    const char *message            = line.text + line.prefix_length;
+    std::size_t message_len        = line.length - line.prefix_length;
+    while ((message_len > 0) && (message[message_len - 1] == '\n')) {
+        --message_len;
+    }
+    // Truncate messages too long for a record.
+    message_len = std::min(message_len, binary::max_payload_size - binary::payload_header_size - header_len - location_len);
+
+    const std::size_t payload_size = binary::payload_header_size + header_len + location_len + message_len;
+    const std::int64_t time        = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // == FRAME ===============================================================
+    out.append(binary::magic, 4);
+    binary::__append_le(out, payload_size, 4);
+    out.append(4, '\0');
+    // == PAYLOAD =============================================================
+    binary::__append_le(out, time, 8);
+    binary::__append_le(out, static_cast<unsigned>(line.level), 1);
+    binary::__append_le(out, header_len, 2);
+    binary::__append_le(out, location_len, 2);
+    out.append(line.header, header_len);
+    out.append(line.location, location_len);
+    out.append(message, message_len);
+
+    // The checksum covers the length and the payload.
+    std::uint32_t checksum = binary::crc32c(&out[start + 4], 4);
+    checksum               = binary::crc32c(&out[start + binary::frame_size], payload_size, checksum);
+    for (std::size_t i = 0; i < 4; ++i) {
+        out[start + 8 + i] = static_cast<char>((checksum >> (8U * i)) & 0xFFU);
+    }
+    record_ends.push_back(out.size());
+}
+
+void binary_sink_t::write_device(const char *data, std::size_t length)
+{
+    // Group whole records in chunks, each written with a single call.
+    std::size_t chunk_start = 0, chunk_end = 0;
+    for (std::size_t i = 0; (i < record_ends.size()) && (record_ends[i] <= length); ++i) {
+        if ((chunk_end > chunk_start) && ((record_ends[i] - chunk_start) > atomic_write_size)) {
+            this->write_chunk(data + chunk_start, chunk_end - chunk_start);
+            chunk_start = chunk_end;
+        }
+        chunk_end = record_ends[i];
+    }
+    if (chunk_end > chunk_start) {
+        this->write_chunk(data + chunk_start, chunk_end - chunk_start);
+    }
+    record_ends.clear();
+}
+
+void binary_sink_t::flush_device()
+{
+    // Nothing to do, every write goes straight to the kernel.
+}
+
+void binary_sink_t::write_chunk(const char *data, std::size_t length)
+{
+    if (since_sync < sync_interval) {
+        if (__write_all(fd, data, length)) {
+            since_sync += length;
+        }
+        return;
+    }
+    // The sync point and the records must land together.
+    chunk.assign(binary::sync_marker, binary::sync_size);
+    chunk.append(data, length);
+    if (__write_all(fd, chunk.data(), chunk.size())) {
+        since_sync = length;
+    }
+    chunk.clear();
+}
+
+} // namespace quire
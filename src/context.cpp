@@ -0,0 +1,110 @@
+/// @file context.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include "quire/context.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <cstdint>
+#else
+#include <atomic>
+#endif
+
+namespace quire
+{
+
+/// @brief The rendered context of the calling thread.
+static inline std::string &__context()
+{
+    static thread_local std::string context;
+    return context;
+}
+
+/// @brief The name of the calling thread, empty until it is first needed.
+static inline std::string &__thread_name()
+{
+    static thread_local std::string name;
+    return name;
+}
+
+/// @brief Returns the identifier of the calling thread.
+static inline unsigned long long __thread_id()
+{
+#ifdef _WIN32
+    return static_cast<unsigned long long>(::GetCurrentThreadId());
+#elif defined(__linux__)
+    return static_cast<unsigned long long>(::syscall(SYS_gettid));
+#elif defined(__APPLE__)
+    std::uint64_t id = 0;
+    ::pthread_threadid_np(nullptr, &id);
+    return static_cast<unsigned long long>(id);
+#else
+    // Number the threads in the order they log.
+    static std::atomic<unsigned long long> next_id(0);
+    return ++next_id;
+#endif
+}
+
+context_guard_t::context_guard_t(const char *key, const std::string &value)
+    : previous_length(0)
+{
+    this->push(key, value.data(), value.size());
+}
+
+context_guard_t::context_guard_t(const char *key, long long value)
+    : previous_length(0)
+{
+    char digits[32];
+    const int length = std::snprintf(digits, sizeof(digits), "%lld", value);
+    this->push(key, digits, static_cast<std::size_t>(length));
+}
+
+context_guard_t::~context_guard_t()
+{
+    // Keep the memory, the next guard will reuse it.
+    __context().resize(previous_length);
+}
+
+const std::string &context_guard_t::current()
+{
+    return __context();
+}
+
+void set_thread_name(const std::string &name)
+{
+    __thread_name() = name;
+}
+
+const std::string &get_thread_name()
+{
+    std::string &name = __thread_name();
+    if (name.empty()) {
+        char digits[32];
+        const int length = std::snprintf(digits, sizeof(digits), "%llu", __thread_id());
+        name.assign(digits, static_cast<std::size_t>(length));
+    }
+    return name;
+}
+
+void context_guard_t::push(const char *key, const char *value, std::size_t length)
+{
+    std::string &context = __context();
+    previous_length      = context.size();
+    if (!context.empty()) {
+        context.push_back(' ');
+    }
+    context.append(key);
+    context.push_back('=');
+    context.append(value, length);
+}
+
+} // namespace quire
@@ -0,0 +1,86 @@
+/// @file hexdump.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include "quire/hexdump.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace quire
+{
+
+/// @brief The hexadecimal digits.
+static const char __digits[] = "0123456789abcdef";
+
+std::size_t render_hexdump_row(char *out, std::size_t offset, const unsigned char *data, std::size_t length)
+{
+    // Two characters for each byte, and the printable characters.
+    char hex[2 * hexdump_row_bytes];
+    char text[hexdump_row_bytes];
+
+#if defined(__SSE2__)
+    if (length == hexdump_row_bytes) {
+        const __m128i bytes  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        const __m128i mask   = _mm_set1_epi8(0x0F);
+        const __m128i nine   = _mm_set1_epi8(9);
+        const __m128i zero   = _mm_set1_epi8('0');
+        const __m128i letter = _mm_set1_epi8('a' - '0' - 10);
+        // Split the bytes in nibbles, and turn each nibble into its digit:
+        // '0' + n, plus the distance to 'a' when the nibble is above nine.
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+        const __m128i low  = _mm_and_si128(bytes, mask);
+        const __m128i high_digits =
+            _mm_add_epi8(_mm_add_epi8(high, zero), _mm_and_si128(_mm_cmpgt_epi8(high, nine), letter));
+        const __m128i low_digits = _mm_add_epi8(_mm_add_epi8(low, zero), _mm_and_si128(_mm_cmpgt_epi8(low, nine), letter));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(hex), _mm_unpacklo_epi8(high_digits, low_digits));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(hex + 16), _mm_unpackhi_epi8(high_digits, low_digits));
+        // As signed bytes, the printable characters are above 0x1F and below 0x7F.
+        const __m128i printable = _mm_and_si128(
+            _mm_cmpgt_epi8(bytes, _mm_set1_epi8(0x1F)), _mm_cmplt_epi8(bytes, _mm_set1_epi8(0x7F)));
+        const __m128i characters =
+            _mm_or_si128(_mm_and_si128(printable, bytes), _mm_andnot_si128(printable, _mm_set1_epi8('.')));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(text), characters);
+    } else
+#endif
+    {
+        for (std::size_t i = 0; i < length; ++i) {
+            hex[2 * i]     = __digits[data[i] >> 4];
+            hex[2 * i + 1] = __digits[data[i] & 0x0F];
+            text[i]        = ((data[i] > 0x1F) && (data[i] < 0x7F)) ? static_cast<char>(data[i]) : '.';
+        }
+    }
+
+    char *position = out;
+    // The offset, on eight digits.
+    for (int shift = 28; shift >= 0; shift -= 4) {
+        *position++ = __digits[(offset >> shift) & 0x0F];
+    }
+    // The bytes, in two groups of eight, padded when the row is short.
+    for (std::size_t i = 0; i < hexdump_row_bytes; ++i) {
+        if ((i % 8) == 0) {
+            *position++ = ' ';
+        }
+        *position++ = ' ';
+        if (i < length) {
+            *position++ = hex[2 * i];
+            *position++ = hex[2 * i + 1];
+        } else {
+            *position++ = ' ';
+            *position++ = ' ';
+        }
+    }
+    *position++ = ' ';
+    *position++ = ' ';
+    *position++ = '|';
+    std::memcpy(position, text, length);
+    position += length;
+    *position++ = '|';
+    *position++ = '\n';
+    return static_cast<std::size_t>(position - out);
+}
+
+} // namespace quire
@@ -0,0 +1,290 @@
+/// @file journald_sink.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include "quire/journald_sink.hpp"
+
+#if defined(__linux__)
+
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <cstring>
+#include <cerrno>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+
+namespace quire
+{
+
+/// @brief Maximum number of entries sent with a single sendmmsg() call.
+static const std::size_t __max_batch = 32;
+
+/// @brief Maps the log level to the syslog priority used by the journal.
+static inline char __journald_priority(log_level level)
+{
+    if (level == debug) {
+        return '7';
+    }
+    if (level == info) {
+        return '6';
+    }
+    if (level == warning) {
+        return '4';
+    }
+    if (level == error) {
+        return '3';
+    }
+    return '2';
+}
+
+/// @brief Appends a field to the entry, using the binary form when the value
+/// contains a newline.
+static inline void __append_field(std::string &out, const char *key, const char *value, std::size_t length)
+{
+    if (std::memchr(value, '\n', length) == nullptr) {
+        out.append(key);
+        out.push_back('=');
+        out.append(value, length);
+        out.push_back('\n');
+    } else {
+        out.append(key);
+        out.push_back('\n');
+        // The length is a 64-bit little-endian integer.
+        for (unsigned i = 0; i < 8; ++i) {
+            out.push_back(static_cast<char>((static_cast<unsigned long long>(length) >> (8U * i)) & 0xFFU));
+        }
+        out.append(value, length);
+        out.push_back('\n');
+    }
+}
+
+journald_sink_t::journald_sink_t(const std::string &_socket_path)
+    : sink_t(),
+      socket_path(_socket_path),
+      fd(-1),
+      max_datagram_size(65536),
+      entry_ends(),
+      dropped(0)
+{
+    fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        throw quire::sink_exception_t(std::string("Failed to create the journal socket: ") + std::strerror(errno));
+    }
+}
+
+journald_sink_t::~journald_sink_t()
+{
+    this->flush();
+    ::close(fd);
+}
+
+const std::string &journald_sink_t::get_socket_path() const
+{
+    return socket_path;
+}
+
+std::size_t journald_sink_t::get_dropped() const
+{
+    return dropped.load();
+}
+
+journald_sink_t &journald_sink_t::set_max_datagram_size(std::size_t _max_datagram_size)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    max_datagram_size = _max_datagram_size;
+    return *this;
+}
+
+bool journald_sink_t::streams_records() const
+{
+    // Each record is a single message, it must be encoded as a whole.
+    return false;
+}
+
+void journald_sink_t::append_line(std::string &out, const line_t &line)
+{
+    const char priority = __journald_priority(line.level);
+    __append_field(out, "PRIORITY", &priority, 1U);
+
+    // The registry pads the headers with spaces, to align them.
+    std::size_t header_length = std::strlen(line.header);
+    while ((header_length > 0) && (line.header[header_length - 1] == ' ')) {
+        --header_length;
+    }
+    if (header_length > 0) {
+        __append_field(out, "SYSLOG_IDENTIFIER", line.header, header_length);
+    }
+
+    // The location is `file:line`.
+    const char *colon = std::strrchr(line.location, ':');
+    if (colon != nullptr) {
+        __append_field(out, "CODE_FILE", line.location, static_cast<std::size_t>(colon - line.location));
+        __append_field(out, "CODE_LINE", colon + 1, std::strlen(colon + 1));
+    }
+
+    // The message, without the prefix and the trailing newline.
+    const char *message    = line.text + line.prefix_length;
+    std::size_t msg_length = line.length - line.prefix_length;
+    while ((msg_length > 0) && ((message[msg_length - 1] == '\n') || (message[msg_length - 1] == '\r'))) {
+        --msg_length;
+    }
+    __append_field(out, "MESSAGE", message, msg_length);
+
+    entry_ends.push_back(out.size());
+}
+
+void journald_sink_t::write_device(const char *data, std::size_t length)
+{
+    const char *entries[__max_batch];
+    std::size_t lengths[__max_batch];
+    std::size_t count = 0;
+    std::size_t start = 0;
+
+    for (std::size_t i = 0; (i < entry_ends.size()) && (entry_ends[i] <= length); ++i) {
+        const std::size_t entry_length = entry_ends[i] - start;
+        if (entry_length > max_datagram_size) {
+            // Keep the order of the entries.
+            this->send_batch(entries, lengths, count);
+            count = 0;
+            if (!this->send_memfd(data + start, entry_length)) {
+                ++dropped;
+            }
+        } else {
+            entries[count] = data + start;
+            lengths[count] = entry_length;
+            if (++count == __max_batch) {
+                this->send_batch(entries, lengths, count);
+                count = 0;
+            }
+        }
+        start = entry_ends[i];
+    }
+    this->send_batch(entries, lengths, count);
+    entry_ends.clear();
+}
+
+void journald_sink_t::flush_device()
+{
+    // Nothing to do, datagrams are not buffered.
+}
+
+void journald_sink_t::send_batch(const char *const *entries, const std::size_t *lengths, std::size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    iovec vectors[__max_batch];
+    mmsghdr messages[__max_batch];
+    std::memset(messages, 0, sizeof(messages));
+    for (std::size_t i = 0; i < count; ++i) {
+        vectors[i].iov_base             = const_cast<char *>(entries[i]);
+        vectors[i].iov_len              = lengths[i];
+        messages[i].msg_hdr.msg_name    = &address;
+        messages[i].msg_hdr.msg_namelen = sizeof(address);
+        messages[i].msg_hdr.msg_iov     = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen  = 1;
+    }
+
+    std::size_t sent = 0;
+    while (sent < count) {
+        const int result = ::sendmmsg(fd, messages + sent, static_cast<unsigned>(count - sent), MSG_NOSIGNAL);
+        if (result > 0) {
+            sent += static_cast<std::size_t>(result);
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EMSGSIZE) {
+            // The daemon accepts less than we thought, use a memfd.
+            if (!this->send_memfd(entries[sent], lengths[sent])) {
+                ++dropped;
+            }
+            ++sent;
+        } else {
+            // The daemon is not there, or it is too slow: we never block.
+            ++dropped;
+            ++sent;
+        }
+    }
+}
+
+bool journald_sink_t::send_memfd(const char *data, std::size_t length)
+{
+#if defined(SYS_memfd_create) && defined(F_ADD_SEALS)
+    const int memfd = static_cast<int>(::syscall(SYS_memfd_create, "quire-journal", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (memfd < 0) {
+        return false;
+    }
+
+    // Write the entry into the memfd.
+    bool success = true;
+    for (std::size_t written = 0; success && (written < length);) {
+        const ssize_t result = ::write(memfd, data + written, length - written);
+        if (result > 0) {
+            written += static_cast<std::size_t>(result);
+        } else if ((result < 0) && (errno != EINTR)) {
+            success = false;
+        }
+    }
+
+    // The daemon only accepts sealed memfds.
+    success = success && (::fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0);
+
+    if (success) {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+        // Pass the descriptor, with no payload.
+        union {
+            cmsghdr header;
+            char data[CMSG_SPACE(sizeof(int))];
+        } control;
+        std::memset(&control, 0, sizeof(control));
+
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_name       = &address;
+        message.msg_namelen    = sizeof(address);
+        message.msg_control    = control.data;
+        message.msg_controllen = sizeof(control.data);
+
+        cmsghdr *cmsg    = CMSG_FIRSTHDR(&message);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type  = SCM_RIGHTS;
+        cmsg->cmsg_len   = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &memfd, sizeof(int));
+
+        ssize_t result;
+        do {
+            result = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+        } while ((result < 0) && (errno == EINTR));
+        success = result >= 0;
+    }
+
+    ::close(memfd);
+    return success;
+#else
+    (void)data;
+    (void)length;
+    return false;
+#endif
+}
+
+} // namespace quire
+
+#endif
@@ -0,0 +1,225 @@
+/// @file pattern.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include "quire/pattern.hpp"
+#include "quire/context.hpp"
+
+#include <chrono>
+#include <cstring>
+
+namespace quire
+{
+
+/// @brief Transforms the log level to string, without padding.
+static inline const char *__level_name(log_level level)
+{
+    if (level == debug) {
+        return "debug";
+    }
+    if (level == info) {
+        return "info";
+    }
+    if (level == warning) {
+        return "warning";
+    }
+    if (level == error) {
+        return "error";
+    }
+    return "critical";
+}
+
+/// @brief Appends the two-digit number.
+static inline char *__put_two_digits(char *out, int value)
+{
+    out[0] = static_cast<char>('0' + (value / 10) % 10);
+    out[1] = static_cast<char>('0' + value % 10);
+    return out + 2;
+}
+
+/// @brief Appends the number with the given number of digits, with leading zeros.
+static inline void __append_digits(std::string &out, unsigned long value, std::size_t digits)
+{
+    char text[16];
+    for (std::size_t i = digits; i > 0; --i) {
+        text[i - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    out.append(text, digits);
+}
+
+pattern_t::pattern_t(const std::string &_pattern)
+    : pattern(_pattern),
+      literals(),
+      ops(),
+      needs_clock(false),
+      last_second(-1),
+      date_text(),
+      time_text()
+{
+    // The fields, longer names first since they share the first letter with shorter ones.
+    static const struct {
+        const char *name;
+        std::size_t length;
+        kind_t kind;
+    } fields[] = {
+        { "loc", 3, location }, { "tid", 3, thread },       { "ctx", 3, context }, { "msg", 3, message }, { "ms", 2, milliseconds },
+        { "us", 2, microseconds }, { "H", 1, header }, { "L", 1, level },     { "D", 1, date },      { "T", 1, time },
+    };
+
+    std::size_t position = 0;
+    while (position < pattern.size()) {
+        // Collect the literal text up to the next field.
+        const std::size_t start = literals.size();
+        while ((position < pattern.size()) && (pattern[position] != '%')) {
+            literals.push_back(pattern[position++]);
+        }
+        if ((position + 1 < pattern.size()) && (pattern[position + 1] == '%')) {
+            literals.push_back('%');
+            position += 2;
+        }
+        if (literals.size() > start) {
+            // Merge with the previous literal, if it is adjacent.
+            if (!ops.empty() && (ops.back().kind == literal)) {
+                ops.back().length = static_cast<std::uint32_t>(literals.size() - ops.back().offset);
+            } else {
+                ops.push_back(op_t{ literal, false, 0, static_cast<std::uint32_t>(start), static_cast<std::uint32_t>(literals.size() - start) });
+            }
+            continue;
+        }
+        if (position >= pattern.size()) {
+            break;
+        }
+        // Parse the width of the field.
+        const std::size_t field_start = position++;
+        op_t op                       = op_t{ literal, false, 0, 0, 0 };
+        if ((position < pattern.size()) && (pattern[position] == '-')) {
+            op.left = true;
+            ++position;
+        }
+        unsigned width = 0;
+        while ((position < pattern.size()) && (pattern[position] >= '0') && (pattern[position] <= '9')) {
+            width = width * 10 + static_cast<unsigned>(pattern[position++] - '0');
+            if (width > 1024) {
+                throw pattern_exception_t("The width of the field at " + std::to_string(field_start) + " is too large.");
+            }
+        }
+        op.width = static_cast<std::uint16_t>(width);
+        // Parse the name of the field.
+        bool found = false;
+        for (std::size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i) {
+            if (pattern.compare(position, fields[i].length, fields[i].name) == 0) {
+                op.kind = fields[i].kind;
+                found   = true;
+                position += fields[i].length;
+                break;
+            }
+        }
+        if (!found) {
+            throw pattern_exception_t("Unknown field at " + std::to_string(field_start) + " of the pattern `" + pattern + "`.");
+        }
+        if (op.kind == message) {
+            // The message follows the prefix, nothing can come after it.
+            if (position != pattern.size()) {
+                throw pattern_exception_t("The message must be the last field of the pattern `" + pattern + "`.");
+            }
+            break;
+        }
+        needs_clock = needs_clock || (op.kind == date) || (op.kind == time) || (op.kind == milliseconds) || (op.kind == microseconds);
+        ops.push_back(op);
+    }
+}
+
+const std::string &pattern_t::get_pattern() const
+{
+    return pattern;
+}
+
+void pattern_t::render(std::string &out, const record_t &record) const
+{
+    // Read the clock once, for all fields.
+    long fraction = 0;
+    if (needs_clock) {
+        const std::chrono::system_clock::duration now = std::chrono::system_clock::now().time_since_epoch();
+        const std::chrono::microseconds micros        = std::chrono::duration_cast<std::chrono::microseconds>(now);
+        const long long seconds                       = micros.count() / 1000000;
+        fraction                                      = static_cast<long>(micros.count() - seconds * 1000000);
+        this->update_clock(static_cast<std::time_t>(seconds));
+    }
+    for (std::vector<op_t>::const_iterator op = ops.begin(); op != ops.end(); ++op) {
+        const std::size_t start = out.size();
+        switch (op->kind) {
+        case literal:
+            out.append(literals, op->offset, op->length);
+            break;
+        case header:
+            out.append(record.header);
+            break;
+        case level:
+            out.append(__level_name(record.level));
+            break;
+        case date:
+            out.append(date_text, 8);
+            break;
+        case time:
+            out.append(time_text, 8);
+            break;
+        case milliseconds:
+            __append_digits(out, static_cast<unsigned long>(fraction / 1000), 3);
+            break;
+        case microseconds:
+            __append_digits(out, static_cast<unsigned long>(fraction), 6);
+            break;
+        case location:
+            out.append(record.location);
+            break;
+        case thread:
+            out.append(get_thread_name());
+            break;
+        case context:
+            out.append(record.context);
+            break;
+        case message:
+            break;
+        }
+        // Pad the field to its width.
+        const std::size_t length = out.size() - start;
+        if (length < op->width) {
+            if (op->left) {
+                out.append(op->width - length, ' ');
+            } else {
+                out.insert(start, op->width - length, ' ');
+            }
+        }
+    }
+}
+
+void pattern_t::update_clock(std::time_t seconds) const
+{
+    if (seconds == last_second) {
+        return;
+    }
+    last_second = seconds;
+    std::tm local;
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char *out = date_text;
+    out       = __put_two_digits(out, local.tm_mday);
+    *out++    = '/';
+    out       = __put_two_digits(out, local.tm_mon + 1);
+    *out++    = '/';
+    out       = __put_two_digits(out, local.tm_year % 100);
+    *out      = '\0';
+    out       = time_text;
+    out       = __put_two_digits(out, local.tm_hour);
+    *out++    = ':';
+    out       = __put_two_digits(out, local.tm_min);
+    *out++    = ':';
+    out       = __put_two_digits(out, local.tm_sec);
+    *out      = '\0';
+}
+
+} // namespace quire
@@ -3,14 +3,22 @@
 /// @brief
 
 #include "quire/quire.hpp"
+#include "quire/context.hpp"
+#include "quire/pattern.hpp"
+#include "quire/sanitize.hpp"
+#include "quire/hexdump.hpp"
+#include "quire/registry.hpp"
+#include "quire/sink.hpp"
+#include "quire/site.hpp"
 
 #include <exception>
 #include <stdexcept>
 #include <cstdarg>
-#include <iomanip>
 #include <iostream>
-#include <sstream>
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
+#include <ctime>
 #include <string>
 
 const char *quire::ansi::fg::black   = "\33[30m";
@@ -56,22 +64,42 @@ const char *quire::ansi::util::prevline  = "\33[1F";
 namespace quire
 {
 
-/// @brief Get the current date.
-static inline std::string __get_date()
+/// @brief The local date and time, rendered once per second and per thread.
+struct clock_cache_t {
+    std::time_t second; ///< The second they were rendered for.
+    char date[9];       ///< The date, as dd/mm/yy.
+    char time[6];       ///< The time, as hh:mm.
+};
+
+/// @brief Messages in a row that fit in the shrink size, before the buffer shrinks.
+static const std::size_t __shrink_delay = 64;
+
+/// @brief Returns the token of the calling thread, which keys its partial
+/// lines. Unlike std::thread::id, it is never reused once the thread exits.
+static inline std::uint64_t __thread_token()
 {
-    char buffer[32];
-    time_t now = time(nullptr);
-    strftime(buffer, 32, "%d/%m/%y", localtime(&now));
-    return std::string(buffer);
+    static std::atomic<std::uint64_t> next(1);
+    static thread_local std::uint64_t token = next.fetch_add(1, std::memory_order_relaxed);
+    return token;
 }
 
-/// @brief Get the current time.
-static inline std::string __get_time()
+/// @brief Returns the local date and time of the current second.
+static inline const clock_cache_t &__get_clock()
 {
-    char buffer[32];
-    time_t now = time(nullptr);
-    strftime(buffer, 32, "%H:%M", localtime(&now));
-    return std::string(buffer);
+    static thread_local clock_cache_t cache = { -1, { 0 }, { 0 } };
+    const std::time_t now = std::time(nullptr);
+    if (now != cache.second) {
+        std::tm local;
+#ifdef _WIN32
+        localtime_s(&local, &now);
+#else
+        localtime_r(&now, &local);
+#endif
+        std::strftime(cache.date, sizeof(cache.date), "%d/%m/%y", &local);
+        std::strftime(cache.time, sizeof(cache.time), "%H:%M", &local);
+        cache.second = now;
+    }
+    return cache;
 }
 
 /// @brief Transforms the log level to string.
@@ -94,26 +122,137 @@ static inline const char *__log_level_to_string(log_level level)
     return "critical";
 }
 
-/// @brief Combines filename and line number.
-static inline std::string __assemble_location(const std::string &file, int line)
+/// @brief Combines filename and line number, reusing the memory of the output.
+static inline void __assemble_location(std::string &out, const char *file, int line)
 {
-    std::stringstream ss;
-    ss << line;
-    return file.substr(file.find_last_of("/\\") + 1) + ":" + ss.str();
+    out.clear();
+    if (file == nullptr) {
+        return;
+    }
+    const char *name = file;
+    for (const char *c = file; *c != '\0'; ++c) {
+        if ((*c == '/') || (*c == '\\')) {
+            name = c + 1;
+        }
+    }
+    out.append(name);
+    out.push_back(':');
+    char digits[16];
+    std::size_t length = 0;
+    unsigned value     = line < 0 ? 0U - static_cast<unsigned>(line) : static_cast<unsigned>(line);
+    do {
+        digits[length++] = static_cast<char>('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+    if (line < 0) {
+        out.push_back('-');
+    }
+    while (length > 0) {
+        out.push_back(digits[--length]);
+    }
 }
 
-logger_t::logger_t(std::string _header, log_level _min_level, char _separator, const std::vector<option_t> &_configuration) noexcept
-    : ostream(&std::cout),
-      fstream(NULL),
-      mtx(),
+/// @brief Appends a column value followed by the separator.
+static inline void __append_column(std::string &out, const char *value, std::size_t length, char separator)
+{
+    out.append(value, length);
+    out.push_back(' ');
+    out.push_back(separator);
+    out.push_back(' ');
+}
+
+void column::header::render(std::string &out, const record_t &record)
+{
+    if (!record.header.empty()) {
+        __append_column(out, record.header.c_str(), record.header.length(), record.separator);
+    }
+}
+
+void column::level::render(std::string &out, const record_t &record)
+{
+    __append_column(out, __log_level_to_string(record.level), 8U, record.separator);
+}
+
+void column::date::render(std::string &out, const record_t &record)
+{
+    __append_column(out, __get_clock().date, 8U, record.separator);
+}
+
+void column::time::render(std::string &out, const record_t &record)
+{
+    __append_column(out, __get_clock().time, 5U, record.separator);
+}
+
+void column::location::render(std::string &out, const record_t &record)
+{
+    if (!record.location.empty()) {
+        out.append(record.location);
+        // Left-align the location on 16 characters.
+        if (record.location.length() < 16U) {
+            out.append(16U - record.location.length(), ' ');
+        }
+        __append_column(out, "", 0U, record.separator);
+    }
+}
+
+void column::context::render(std::string &out, const record_t &record)
+{
+    if (!record.context.empty()) {
+        __append_column(out, record.context.data(), record.context.size(), record.separator);
+    }
+}
+
+void column::thread::render(std::string &out, const record_t &record)
+{
+    const std::string &name = get_thread_name();
+    __append_column(out, name.data(), name.size(), record.separator);
+}
+
+namespace detail
+{
+
+void mark_truncated(char *message, std::size_t size, std::size_t length, bool newline)
+{
+    char marker[64];
+    const int marker_length = std::snprintf(
+        marker, sizeof(marker), newline ? " [truncated, %llu bytes in total]\n" : " [truncated, %llu bytes in total]",
+        static_cast<unsigned long long>(length));
+    if (static_cast<std::size_t>(marker_length) >= size) {
+        return;
+    }
+    // Place the marker at the end, without splitting a UTF-8 sequence.
+    std::size_t position = size - 1 - static_cast<std::size_t>(marker_length);
+    while ((position > 0) && ((static_cast<unsigned char>(message[position]) & 0xC0) == 0x80)) {
+        --position;
+    }
+    std::memcpy(message + position, marker, static_cast<std::size_t>(marker_length) + 1);
+}
+
+} // namespace detail
+
+logger_base_t::logger_base_t(std::string _header, log_level _min_level, char _separator)
+    : output_sink(registry_t::instance().stream_sink(&std::cout)),
+      file_sink(),
+      sinks(),
       header(_header),
       min_level(_min_level),
-      last_log_ended_with_newline(true),
       enable_color(true),
-      configuration(_configuration),
       separator(_separator),
       buffer(nullptr),
       buffer_length(0),
+      max_message_size(0),
+      buffer_shrink_size(65536),
+      small_messages(0),
+      line_buffer(),
+      location_buffer(),
+      pending_lines(),
+      pending_count(0),
+      partial_line_timeout(1000),
+      enable_sanitize(false),
+      sanitized(),
+      record_location(),
+      record_sinks(),
+      record_newline(true),
       fg_colors(),
       bg_colors()
 {
@@ -130,48 +269,66 @@ logger_t::logger_t(std::string _header, log_level _min_level, char _separator, c
     bg_colors[warning]  = quire::ansi::util::reset;
     bg_colors[error]    = quire::ansi::util::reset;
     bg_colors[critical] = quire::ansi::util::reset;
+
+#ifdef QUIRE_HAS_STATIC_KEYS
+    // Call sites of this level, and above, must jump to their check.
+    site_registry_t::instance().retain_level(_min_level);
+#endif
 }
 
-logger_t::logger_t(logger_t &&other) noexcept
-    : ostream(other.ostream),
-      fstream(other.fstream),
+logger_base_t::logger_base_t(logger_base_t &&other) noexcept
+    : output_sink(std::move(other.output_sink)),
+      file_sink(std::move(other.file_sink)),
+      sinks(std::move(other.sinks)),
       header(std::move(other.header)),
-      min_level(other.min_level),
-      last_log_ended_with_newline(other.last_log_ended_with_newline),
+      min_level(other.min_level.load()),
       enable_color(other.enable_color),
-      configuration(std::move(other.configuration)),
       separator(other.separator),
       buffer(other.buffer),
-      buffer_length(other.buffer_length)
+      buffer_length(other.buffer_length),
+      max_message_size(other.max_message_size),
+      buffer_shrink_size(other.buffer_shrink_size),
+      small_messages(other.small_messages),
+      line_buffer(std::move(other.line_buffer)),
+      location_buffer(),
+      pending_lines(std::move(other.pending_lines)),
+      pending_count(other.pending_count),
+      partial_line_timeout(other.partial_line_timeout),
+      enable_sanitize(other.enable_sanitize),
+      sanitized(),
+      record_location(),
+      record_sinks(),
+      record_newline(true)
 {
     // Move the fg_colors and bg_colors arrays
     std::copy(std::begin(other.fg_colors), std::end(other.fg_colors), fg_colors);
     std::copy(std::begin(other.bg_colors), std::end(other.bg_colors), bg_colors);
 
     // Nullify moved-from resources in `other`.
-    other.ostream       = nullptr;
-    other.fstream       = nullptr;
     other.buffer        = nullptr;
     other.buffer_length = 0;
+    other.pending_count = 0;
+
+#ifdef QUIRE_HAS_STATIC_KEYS
+    // The moved-from logger keeps its level until it is destroyed.
+    site_registry_t::instance().retain_level(min_level.load());
+#endif
 }
 
-void logger_t::print_logger_state() const
+void logger_base_t::print_logger_state() const
 {
-    std::cout << "ostream       : " << (ostream ? "valid" : "null") << '\n';
-    std::cout << "fstream       : " << (fstream ? "valid" : "null") << '\n';
-    // std::mutex mtx;
+    std::cout << "output_sink   : " << (output_sink ? "valid" : "null") << '\n';
+    std::cout << "file_sink     : " << (file_sink ? "valid" : "null") << '\n';
+    std::cout << "sinks         : " << sinks.size() << '\n';
     std::cout << "header        : " << header << '\n';
-    std::cout << "min_level     : " << static_cast<int>(min_level) << '\n';
-    std::cout << "LLEWNL        : " << (last_log_ended_with_newline ? "true" : "false") << '\n';
+    std::cout << "min_level     : " << static_cast<int>(min_level.load()) << '\n';
+    std::cout << "pending_lines : " << pending_count << '\n';
     std::cout << "enable_color  : " << (enable_color ? "true" : "false") << '\n';
-    std::cout << "configuration : { ";
-    for (const auto &option : configuration) {
-        std::cout << static_cast<int>(option) << " ";
-    }
-    std::cout << "}\n";
     std::cout << "separator     : " << separator << '\n';
     std::cout << "buffer        : " << (buffer ? "valid" : "null") << '\n';
     std::cout << "buffer_length : " << buffer_length << '\n';
+    std::cout << "max_message   : " << max_message_size << '\n';
+    std::cout << "shrink_size   : " << buffer_shrink_size << '\n';
     std::cout << "fg_colors     : { ";
     for (std::size_t i = 0; i < 5; ++i) {
         std::cout << (fg_colors[i] ? "valid" : "null") << " ";
@@ -184,22 +341,28 @@ void logger_t::print_logger_state() const
     std::cout << "}\n";
 }
 
-logger_t::~logger_t()
+logger_base_t::~logger_base_t()
 {
+    // Do not lose the partial lines.
+    this->flush_pending_lines();
     std::free(buffer);
+
+#ifdef QUIRE_HAS_STATIC_KEYS
+    site_registry_t::instance().release_level(min_level.load());
+#endif
 }
 
-std::string logger_t::get_header() const
+std::string logger_base_t::get_header() const
 {
     return header;
 }
 
-log_level logger_t::get_log_level() const
+log_level logger_base_t::get_log_level() const
 {
-    return min_level;
+    return min_level.load();
 }
 
-logger_t &logger_t::reset_colors()
+logger_base_t &logger_base_t::reset_colors()
 {
     // Default foreground colors.
     fg_colors[debug]    = ansi::fg::cyan;
@@ -217,37 +380,70 @@ logger_t &logger_t::reset_colors()
     return *this;
 }
 
-logger_t &logger_t::set_file_handler(std::ostream *_fstream)
+logger_base_t &logger_base_t::set_file_handler(std::ostream *_fstream)
 {
-    fstream = _fstream;
+    file_sink = _fstream ? registry_t::instance().stream_sink(_fstream) : nullptr;
     return *this;
 }
 
-logger_t &logger_t::set_output_stream(std::ostream *_ostream)
+logger_base_t &logger_base_t::set_output_stream(std::ostream *_ostream)
 {
-    ostream = _ostream;
+    output_sink = _ostream ? registry_t::instance().stream_sink(_ostream) : nullptr;
     return *this;
 }
 
-logger_t &logger_t::set_header(std::string _header)
+logger_base_t &logger_base_t::set_file_sink(std::shared_ptr<sink_t> _sink)
+{
+    file_sink = std::move(_sink);
+    return *this;
+}
+
+logger_base_t &logger_base_t::set_output_sink(std::shared_ptr<sink_t> _sink)
+{
+    output_sink = std::move(_sink);
+    return *this;
+}
+
+logger_base_t &logger_base_t::add_sink(std::shared_ptr<sink_t> _sink)
+{
+    if (_sink && (std::find(sinks.begin(), sinks.end(), _sink) == sinks.end())) {
+        sinks.push_back(std::move(_sink));
+    }
+    return *this;
+}
+
+logger_base_t &logger_base_t::remove_sink(const std::shared_ptr<sink_t> &_sink)
+{
+    sinks.erase(std::remove(sinks.begin(), sinks.end(), _sink), sinks.end());
+    return *this;
+}
+
+logger_base_t &logger_base_t::set_header(std::string _header)
 {
     header = _header;
     return *this;
 }
 
-logger_t &logger_t::set_log_level(log_level _level)
+logger_base_t &logger_base_t::set_log_level(log_level _level)
 {
+#ifdef QUIRE_HAS_STATIC_KEYS
+    // Enable the new level before disabling the old one, so that the sites
+    // both levels enable never skip their check.
+    site_registry_t::instance().retain_level(_level);
+    site_registry_t::instance().release_level(min_level.exchange(_level));
+#else
     min_level = _level;
+#endif
     return *this;
 }
 
-logger_t &logger_t::set_separator(char _separator)
+logger_base_t &logger_base_t::set_separator(char _separator)
 {
     separator = _separator;
     return *this;
 }
 
-logger_t &logger_t::set_color(log_level level, const char *fg, const char *bg)
+logger_base_t &logger_base_t::set_color(log_level level, const char *fg, const char *bg)
 {
     if ((level >= debug) && (level <= critical)) {
         fg_colors[level] = fg;
@@ -256,93 +452,148 @@ logger_t &logger_t::set_color(log_level level, const char *fg, const char *bg)
     return *this;
 }
 
-logger_t &logger_t::toggle_color(bool enable)
+logger_base_t &logger_base_t::toggle_color(bool enable)
 {
     enable_color = enable;
     return *this;
 }
 
-logger_t &logger_t::configure(const std::vector<option_t> &_configuration)
+logger_base_t &logger_base_t::set_partial_line_timeout(std::chrono::milliseconds _timeout)
 {
-    configuration = _configuration;
+    partial_line_timeout = _timeout;
+    return *this;
+}
+
+logger_base_t &logger_base_t::toggle_sanitize(bool enable)
+{
+    enable_sanitize = enable;
+    return *this;
+}
+
+logger_base_t &logger_base_t::set_max_message_size(std::size_t _size)
+{
+    max_message_size = ((_size > 0) && (_size < 128)) ? 128 : _size;
+    return *this;
+}
+
+logger_base_t &logger_base_t::set_buffer_shrink_size(std::size_t _size)
+{
+    buffer_shrink_size = ((_size > 0) && (_size < 128)) ? 128 : _size;
     return *this;
 }
 
-void logger_t::format_message(char const *format, va_list args)
+void logger_base_t::write(log_level level, char const *file, int line, char const *format, va_list args)
+{
+    // Format the message, and pass it with the level and the location.
+    this->write_message(level, file, line, this->format_message(format, args));
+
+    // Give back the memory taken by large messages, once they stop coming,
+    // so that a stream of them does not grow and shrink the buffer each time.
+    if ((buffer_shrink_size > 0) && (buffer_length > buffer_shrink_size) && (small_messages >= __shrink_delay)) {
+        char *new_buffer = reinterpret_cast<char *>(std::realloc(buffer, buffer_shrink_size));
+        if (new_buffer != nullptr) {
+            buffer        = new_buffer;
+            buffer_length = buffer_shrink_size;
+        }
+    }
+}
+
+void logger_base_t::write_message(log_level level, char const *file, int line, char const *message) const
+{
+    // Clean messages are written as they are, without copies.
+    if (enable_sanitize && (message != nullptr) && sanitize(message, std::strlen(message), sanitized)) {
+        message = sanitized.c_str();
+    }
+    __assemble_location(location_buffer, file, line);
+    this->write_log(level, location_buffer, message);
+}
+
+const char *logger_base_t::format_message(char const *format, va_list args)
 {
     if ((format == nullptr) || (format[0] == '\0')) {
         // Clean the buffer by setting it to an empty string.
         if (buffer != nullptr && buffer_length > 0) {
             buffer[0] = '\0';
         }
-    } else {
-        // Initialize variable argument lists to format the message.
-        va_list length_args;
-        va_copy(length_args, args);
-
-        // Calculate the length of the formatted string.
-        const int length = std::vsnprintf(nullptr, 0U, format, length_args);
-        va_end(length_args);
-
-        if (length > 0) {
-            // Check if the buffer needs to be resized.
-            if (buffer_length < static_cast<std::size_t>(length) + 1) {
-                // Double the buffer length until it can hold the formatted string.
-                while (buffer_length < static_cast<std::size_t>(length) + 1) {
-                    buffer_length = buffer_length == 0 ? 128 : buffer_length * 2;
-                }
-
-                char *new_buffer = reinterpret_cast<char *>(std::realloc(buffer, buffer_length));
-                if (new_buffer == nullptr) {
-                    // Handle memory allocation failure.
-                    perror("Failed to allocate memory for buffer resizing.");
-                    exit(EXIT_FAILURE);
-                }
-                buffer = new_buffer;
-            }
+        return buffer;
+    }
+
+    // Initialize variable argument lists to format the message.
+    va_list length_args;
+    va_copy(length_args, args);
 
-            // Format the message into the buffer.
-            std::vsnprintf(buffer, buffer_length, format, args);
+    // Calculate the length of the formatted string.
+    const int length = std::vsnprintf(nullptr, 0U, format, length_args);
+    va_end(length_args);
+
+    if (length <= 0) {
+        // Do not write the previous message again.
+        if (buffer != nullptr && buffer_length > 0) {
+            buffer[0] = '\0';
         }
+        return buffer;
     }
-}
 
-void logger_t::log(log_level level, char const *format, ...)
-{
-    // Ensure thread safety by locking the mutex.
-    std::lock_guard<std::mutex> lock(mtx);
-
-    if (level >= min_level) {
-        // Format the message.
-        va_list args;
-        va_start(args, format);
-        this->format_message(format, args);
-        va_end(args);
+    // Keep the message within the maximum size.
+    const std::size_t needed = static_cast<std::size_t>(length) + 1;
+    std::size_t size         = ((max_message_size > 0) && (needed > max_message_size)) ? max_message_size : needed;
+    small_messages           = (size <= buffer_shrink_size) ? small_messages + 1 : 0;
+    if (!this->reserve_buffer(size)) {
+        // Without memory, write what fits in the buffer we have.
+        if (buffer_length < 64) {
+            return "[message dropped, out of memory]\n";
+        }
+        size = buffer_length;
+    }
 
-        // Pass the level, location, and buffer to do_log.
-        this->write_log(level, std::string(), buffer);
+    // Format the message into the buffer.
+    std::vsnprintf(buffer, size, format, args);
+    if (size < needed) {
+        detail::mark_truncated(buffer, size, static_cast<std::size_t>(length), format[std::strlen(format) - 1] == '\n');
     }
+    return buffer;
 }
 
-void logger_t::log(log_level level, char const *file, int line, char const *format, ...)
+bool logger_base_t::reserve_buffer(std::size_t size)
 {
-    // Ensure thread safety by locking the mutex.
-    std::lock_guard<std::mutex> lock(mtx);
-
-    if (level >= min_level) {
-        // Format the message.
-        va_list args;
-        va_start(args, format);
-        this->format_message(format, args);
-        va_end(args);
-
-        // Pass the level, location, and buffer to do_log.
-        this->write_log(level, __assemble_location(file, line), buffer);
+    if (buffer_length >= size) {
+        return true;
+    }
+    // Double the buffer length until it can hold the message, without
+    // going beyond the maximum size.
+    std::size_t new_length = buffer_length == 0 ? 128 : buffer_length;
+    while (new_length < size) {
+        new_length *= 2;
+    }
+    if ((max_message_size > 0) && (new_length > max_message_size)) {
+        new_length = max_message_size;
     }
+    char *new_buffer = reinterpret_cast<char *>(std::realloc(buffer, new_length));
+    if ((new_buffer == nullptr) && (new_length > size)) {
+        // Try again, asking only for what is needed.
+        new_length = size;
+        new_buffer = reinterpret_cast<char *>(std::realloc(buffer, new_length));
+    }
+    if (new_buffer == nullptr) {
+        return false;
+    }
+    buffer        = new_buffer;
+    buffer_length = new_length;
+    return true;
 }
 
-void logger_t::write_log(log_level level, const std::string &location, const char *content) const
+void logger_base_t::write_log(log_level level, const std::string &location, const char *content) const
 {
+    // Nothing to write if the buffer was never allocated.
+    if (content == nullptr) {
+        return;
+    }
+
+    // Write the partial lines of other threads that waited too long.
+    if (pending_count > 0) {
+        this->expire_pending_lines();
+    }
+
     const char *start   = content;
     const char *newline = nullptr;
 
@@ -364,57 +615,455 @@ void logger_t::write_log(log_level level, const std::string &location, const cha
     }
 }
 
-void logger_t::write_log_line(log_level level, const std::string &location, const char *line, std::size_t length) const
+void logger_base_t::write_log_line(log_level level, const std::string &location, const char *line, std::size_t length) const
 {
-    std::stringstream ss;
+    // Check if the line is complete.
+    const bool complete = (length > 0) && ((line[length - 1] == '\n') || (line[length - 1] == '\r'));
 
-    // == LOG INFORMATION =====================================================
-    // Add the header only if the previous log ended with a newline
-    if (last_log_ended_with_newline) {
-        for (std::size_t i = 0; i < configuration.size(); ++i) {
-            if ((configuration[i] == option_t::header) && !header.empty()) {
-                ss << header << " " << separator << " ";
-            } else if (configuration[i] == option_t::level) {
-                ss << __log_level_to_string(level) << " " << separator << " ";
-            } else if (configuration[i] == option_t::date) {
-                ss << __get_date() << " " << separator << " ";
-            } else if (configuration[i] == option_t::time) {
-                ss << __get_time() << " " << separator << " ";
-            } else if ((configuration[i] == option_t::location) && !location.empty()) {
-                ss << std::left << std::setw(16) << location << " " << separator << " ";
+    // Continue the partial line left by this thread, if any.
+    if (pending_count > 0) {
+        pending_map_t::iterator it = pending_lines.find(__thread_token());
+        if ((it != pending_lines.end()) && it->second.waiting) {
+            it->second.content.append(line, length);
+            if (complete) {
+                this->emit_line(it->second.level, it->second.location, it->second.content, it->second.prefix_length);
+                it->second.waiting = false;
+                --pending_count;
             }
+            return;
         }
     }
 
-    // Check that the line is not empty.
-    if ((line != NULL) && (line[0] != '\0')) {
-        // Write the actual log message.
-        ss.write(line, static_cast<std::streamsize>(length));
-
-        // Update the newline flag based on the current message's last character.
-        last_log_ended_with_newline = (length > 0 && ((line[length - 1] == '\n') || (line[length - 1] == '\r')));
+    if (complete) {
+        // Assemble the prefix and the line, and write them at once.
+        line_buffer.clear();
+        this->render_prefix(line_buffer, record_t{ header, location, level, separator, context_guard_t::current() });
+        const std::size_t prefix_length = line_buffer.size();
+        line_buffer.append(line, length);
+        this->emit_line(level, location, line_buffer, prefix_length);
+    } else {
+        // Keep the line aside until its newline arrives, in the entry the
+        // thread used last time, if any, so that its strings are reused.
+        pending_line_t &pending = pending_lines[__thread_token()];
+        pending.content.clear();
+        this->render_prefix(pending.content, record_t{ header, location, level, separator, context_guard_t::current() });
+        pending.prefix_length = pending.content.size();
+        pending.content.append(line, length);
+        pending.location = location;
+        pending.level    = level;
+        pending.since    = std::chrono::steady_clock::now();
+        pending.waiting  = true;
+        ++pending_count;
     }
+}
 
-    // == WRITE TO FILE STREAM ================================================
-    if (fstream) {
-        (*fstream) << ss.str();
+void logger_base_t::emit_line(log_level level, const std::string &location, const std::string &text, std::size_t prefix_length) const
+{
+    line_t line{ level, nullptr, nullptr, header.c_str(), location.c_str(), text.data(), text.size(), prefix_length };
+
+    // == WRITE TO FILE SINKS =================================================
+    if (file_sink) {
+        file_sink->write(line);
+    }
+    for (std::size_t i = 0; i < sinks.size(); ++i) {
+        sinks[i]->write(line);
     }
 
-    if (ostream) {
-        // == COLOR (ON) ======================================================
+    // == WRITE TO OUTPUT SINK ================================================
+    if (output_sink) {
         if (enable_color && (level >= debug) && (level <= critical)) {
-            (*ostream) << bg_colors[level] << fg_colors[level];
+            line.fg = fg_colors[level];
+            line.bg = bg_colors[level];
         }
+        output_sink->write(line);
+    }
+}
+
+void logger_base_t::prepare(std::size_t message_size)
+{
+    // Load the time zone, and render the date and time of this thread.
+#ifdef _WIN32
+    _tzset();
+#else
+    tzset();
+#endif
+    __get_clock();
+    get_thread_name();
 
-        // == WRITE STREAM ====================================================
-        (*ostream) << ss.str();
+    // Size the formatting buffer, without going past the shrink size, and
+    // run the formatting code once, touching the memory of the buffer.
+    if ((buffer_shrink_size > 0) && (message_size > buffer_shrink_size)) {
+        message_size = buffer_shrink_size;
+    }
+    if (this->reserve_buffer(message_size)) {
+        std::memset(buffer, ' ', buffer_length);
+        std::snprintf(buffer, buffer_length, "%d %.3f %s", 42, 3.14, "warmup");
+        buffer[0] = '\0';
+    }
+
+    // Render a prefix, which also primes the caches of the layout.
+    __assemble_location(location_buffer, __FILE__, __LINE__);
+    line_buffer.assign(message_size + 256, ' ');
+    line_buffer.clear();
+    this->render_prefix(line_buffer, record_t{ header, location_buffer, info, separator, context_guard_t::current() });
+    line_buffer.clear();
+    if (enable_sanitize) {
+        sanitized.reserve(message_size + 16);
+    }
+
+    // Prepare the sinks.
+    if (file_sink) {
+        file_sink->warmup();
+    }
+    for (std::size_t i = 0; i < sinks.size(); ++i) {
+        sinks[i]->warmup();
+    }
+    if (output_sink) {
+        output_sink->warmup();
+    }
+
+    // Create the site registry, the sites attach to it on their first call.
+    site_registry_t::instance();
+}
+
+void logger_base_t::write_hexdump(log_level level, char const *file, int line, const void *data, std::size_t length) const
+{
+    // Write the partial lines of other threads that waited too long.
+    if (pending_count > 0) {
+        this->expire_pending_lines();
+    }
 
-        // == COLOR (OFF) =====================================================
-        if (enable_color) {
-            (*ostream) << ansi::util::reset;
+    // Render the prefix once, each row is then written after it.
+    __assemble_location(location_buffer, file, line);
+    const std::string &location = location_buffer;
+    line_buffer.clear();
+    this->render_prefix(line_buffer, record_t{ header, location, level, separator, context_guard_t::current() });
+    const std::size_t prefix_length = line_buffer.size();
+
+    // Only the last row can be shorter, the others overwrite the same space.
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    line_buffer.resize(prefix_length + hexdump_row_length);
+    for (std::size_t offset = 0; offset < length; offset += hexdump_row_bytes) {
+        const std::size_t count = std::min(hexdump_row_bytes, length - offset);
+        const std::size_t row   = render_hexdump_row(&line_buffer[prefix_length], offset, bytes + offset, count);
+        if (row < hexdump_row_length) {
+            line_buffer.resize(prefix_length + row);
+        }
+        this->emit_line(level, location, line_buffer, prefix_length);
+    }
+}
+
+void logger_base_t::start_record(log_level level, char const *file, int line)
+{
+    // Write the partial lines of other threads that waited too long.
+    if (pending_count > 0) {
+        this->expire_pending_lines();
+    }
+
+    __assemble_location(record_location, file, line);
+    line_buffer.clear();
+    this->render_prefix(line_buffer, record_t{ header, record_location, level, separator, context_guard_t::current() });
+
+    // Lock the sinks in the order of their address, like any other logger
+    // writing a record to the same sinks.
+    record_sinks.clear();
+    if (file_sink) {
+        record_sinks.emplace_back(file_sink.get(), false);
+    }
+    for (std::size_t i = 0; i < sinks.size(); ++i) {
+        record_sinks.emplace_back(sinks[i].get(), false);
+    }
+    if (output_sink) {
+        record_sinks.emplace_back(output_sink.get(), enable_color && (level >= debug) && (level <= critical));
+    }
+    std::sort(record_sinks.begin(), record_sinks.end());
+    record_sinks.erase(
+        std::unique(
+            record_sinks.begin(), record_sinks.end(),
+            [](const record_sink_t &a, const record_sink_t &b) { return a.first == b.first; }),
+        record_sinks.end());
+
+    line_t prefix{ level, nullptr, nullptr, header.c_str(), record_location.c_str(), line_buffer.data(), line_buffer.size(), line_buffer.size() };
+    std::size_t i = 0;
+    try {
+        for (; i < record_sinks.size(); ++i) {
+            prefix.fg = record_sinks[i].second ? fg_colors[level] : nullptr;
+            prefix.bg = record_sinks[i].second ? bg_colors[level] : nullptr;
+            record_sinks[i].first->begin_record(prefix);
+        }
+    } catch (...) {
+        // Unlock the sinks we already locked, they write just the prefix.
+        record_sinks.resize(i);
+        record_newline = false;
+        this->finish_record();
+        throw;
+    }
+    record_newline = true;
+}
+
+void logger_base_t::append_record(const char *data, std::size_t length)
+{
+    if (length == 0) {
+        return;
+    }
+    for (std::size_t i = 0; i < record_sinks.size(); ++i) {
+        record_sinks[i].first->append_record(data, length);
+    }
+    record_newline = (data[length - 1] == '\n');
+}
+
+void logger_base_t::finish_record()
+{
+    // Every sink is unlocked, even if one of them fails, then the first
+    // failure is thrown again.
+    std::exception_ptr failure;
+    if (!record_newline) {
+        try {
+            this->append_record("\n", 1);
+        } catch (...) {
+            failure = std::current_exception();
+        }
+    }
+    for (std::size_t i = 0; i < record_sinks.size(); ++i) {
+        try {
+            record_sinks[i].first->end_record();
+        } catch (...) {
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+    }
+    record_sinks.clear();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void logger_base_t::expire_pending_lines() const
+{
+    // Partial lines can wait indefinitely.
+    if (partial_line_timeout.count() <= 0) {
+        return;
+    }
+    // The thread of an expired line may have exited, so its entry goes.
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (pending_map_t::iterator it = pending_lines.begin(); it != pending_lines.end();) {
+        if (it->second.waiting && ((now - it->second.since) >= partial_line_timeout)) {
+            it->second.content.push_back('\n');
+            this->emit_line(it->second.level, it->second.location, it->second.content, it->second.prefix_length);
+            it = pending_lines.erase(it);
+            --pending_count;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void logger_base_t::flush_pending_lines() const
+{
+    for (pending_map_t::iterator it = pending_lines.begin(); it != pending_lines.end();) {
+        if (it->second.waiting) {
+            it->second.content.push_back('\n');
+            this->emit_line(it->second.level, it->second.location, it->second.content, it->second.prefix_length);
+        }
+        it = pending_lines.erase(it);
+    }
+    pending_count = 0;
+}
+
+void logger_base_t::flush_sinks() const
+{
+    if (file_sink) {
+        file_sink->flush();
+    }
+    for (std::size_t i = 0; i < sinks.size(); ++i) {
+        sinks[i]->flush();
+    }
+    if (output_sink) {
+        output_sink->flush();
+    }
+}
+
+logger_t::logger_t(std::string _header, log_level _min_level, char _separator, const std::vector<option_t> &_configuration)
+    : logger_base_t(std::move(_header), _min_level, _separator),
+      mtx(),
+      configuration(_configuration),
+      pattern()
+{
+    // Nothing to do.
+}
+
+logger_t::logger_t(logger_t &&other) noexcept
+    : logger_base_t(std::move(other)),
+      mtx(),
+      configuration(std::move(other.configuration)),
+      pattern(std::move(other.pattern))
+{
+    // Nothing to do.
+}
+
+logger_t::~logger_t()
+{
+    // Nothing to do.
+}
+
+void logger_t::print_logger_state() const
+{
+    logger_base_t::print_logger_state();
+    std::cout << "configuration : { ";
+    for (const auto &option : configuration) {
+        std::cout << static_cast<int>(option) << " ";
+    }
+    std::cout << "}\n";
+    std::cout << "pattern       : " << (pattern ? pattern->get_pattern() : "none") << '\n';
+}
+
+logger_t &logger_t::configure(const std::vector<option_t> &_configuration)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    configuration = _configuration;
+    pattern.reset();
+    return *this;
+}
+
+logger_t &logger_t::set_pattern(const std::string &_pattern)
+{
+    // Compile the pattern before taking the lock, it can throw.
+    std::unique_ptr<pattern_t> compiled(_pattern.empty() ? nullptr : new pattern_t(_pattern));
+    std::lock_guard<std::mutex> lock(mtx);
+    pattern = std::move(compiled);
+    return *this;
+}
+
+void logger_t::log(log_level level, char const *format, ...)
+{
+    // Ensure thread safety by locking the mutex.
+    std::lock_guard<std::mutex> lock(mtx);
+
+    if (this->is_enabled(level)) {
+        va_list args;
+        va_start(args, format);
+        this->write(level, nullptr, 0, format, args);
+        va_end(args);
+    }
+}
+
+void logger_t::log(log_level level, char const *file, int line, char const *format, ...)
+{
+    // Ensure thread safety by locking the mutex.
+    std::lock_guard<std::mutex> lock(mtx);
+
+    if (this->is_enabled(level)) {
+        va_list args;
+        va_start(args, format);
+        this->write(level, file, line, format, args);
+        va_end(args);
+    }
+}
+
+void logger_t::log(const site_t &site, log_level level, char const *format, ...)
+{
+    // Ensure thread safety by locking the mutex.
+    std::lock_guard<std::mutex> lock(mtx);
+
+    va_list args;
+    va_start(args, format);
+    this->write(level, site.get_file(), site.get_line(), format, args);
+    va_end(args);
+}
+
+void logger_t::log_message(log_level level, char const *file, int line, char const *message)
+{
+    // Ensure thread safety by locking the mutex.
+    std::lock_guard<std::mutex> lock(mtx);
+
+    if (this->is_enabled(level)) {
+        this->write_message(level, file, line, message);
+    }
+}
+
+void logger_t::log_message(const site_t &site, log_level level, char const *message)
+{
+    // Ensure thread safety by locking the mutex.
+    std::lock_guard<std::mutex> lock(mtx);
+
+    this->write_message(level, site.get_file(), site.get_line(), message);
+}
+
+void logger_t::warmup(std::size_t message_size)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    this->prepare(message_size);
+}
+
+void logger_t::hexdump(log_level level, char const *file, int line, const void *data, std::size_t length)
+{
+    // Ensure thread safety by locking the mutex.
+    std::lock_guard<std::mutex> lock(mtx);
+
+    if (this->is_enabled(level)) {
+        this->write_hexdump(level, file, line, data, length);
+    }
+}
+
+bool logger_t::begin_record(log_level level, char const *file, int line)
+{
+    if (!this->is_enabled(level)) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(mtx);
+    this->start_record(level, file, line);
+    // The logger stays locked until end_record.
+    lock.release();
+    return true;
+}
+
+void logger_t::append(const char *data, std::size_t length)
+{
+    this->append_record(data, length);
+}
+
+void logger_t::append(const std::string &data)
+{
+    this->append_record(data.data(), data.size());
+}
+
+void logger_t::end_record()
+{
+    std::lock_guard<std::mutex> lock(mtx, std::adopt_lock);
+    this->finish_record();
+}
+
+void logger_t::flush()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    this->flush_pending_lines();
+    this->flush_sinks();
+}
+
+void logger_t::render_prefix(std::string &out, const record_t &record) const
+{
+    if (pattern) {
+        pattern->render(out, record);
+        return;
+    }
+    for (std::size_t i = 0; i < configuration.size(); ++i) {
+        if (configuration[i] == option_t::header) {
+            column::header::render(out, record);
+        } else if (configuration[i] == option_t::level) {
+            column::level::render(out, record);
+        } else if (configuration[i] == option_t::date) {
+            column::date::render(out, record);
+        } else if (configuration[i] == option_t::time) {
+            column::time::render(out, record);
+        } else if (configuration[i] == option_t::location) {
+            column::location::render(out, record);
+        } else if (configuration[i] == option_t::context) {
+            column::context::render(out, record);
+        } else if (configuration[i] == option_t::thread) {
+            column::thread::render(out, record);
         }
-        std::flush(*ostream);
     }
 }
 
-} // namespace quire
\ No newline at end of file
+} // namespace quire
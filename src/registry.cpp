@@ -38,7 +38,10 @@ inline std::string lalign(std::string s, std::string::size_type width, char fill
 
 registry_t::registry_t()
     : m_map(),
-      mtx()
+      mtx(),
+      m_sinks(),
+      m_stream_sinks(),
+      sink_mtx()
 {
     // Nothing to do.
 }
@@ -182,4 +185,96 @@ void registry_t::adjust_header_length()
     }
 }
 
+registry_t::sink_ptr_t registry_t::add_sink(const std::string &name, registry_t::sink_ptr_t sink)
+{
+    std::lock_guard<std::mutex> lock(sink_mtx);
+
+    // Check if the sink already exists.
+    if (m_sinks.find(name) != m_sinks.end()) {
+        std::stringstream ss;
+        ss << "Sink `" << name << "` already exists.";
+        throw quire::registry_exception_t(ss.str());
+    }
+    m_sinks[name] = sink;
+    return sink;
+}
+
+registry_t::sink_ptr_t registry_t::get_sink(const std::string &name) const
+{
+    std::lock_guard<std::mutex> lock(sink_mtx);
+
+    // Check if the sink exists.
+    sink_map_t::const_iterator it = m_sinks.find(name);
+    if (it == m_sinks.end()) {
+        std::stringstream ss;
+        ss << "Sink `" << name << "` does not exists.";
+        throw quire::registry_exception_t(ss.str());
+    }
+    return it->second;
+}
+
+void registry_t::remove_sink(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(sink_mtx);
+    m_sinks.erase(name);
+}
+
+bool registry_t::contains_sink(const std::string &name) const
+{
+    std::lock_guard<std::mutex> lock(sink_mtx);
+    return m_sinks.find(name) != m_sinks.end();
+}
+
+registry_t::sink_ptr_t registry_t::stream_sink(std::ostream *stream)
+{
+    std::lock_guard<std::mutex> lock(sink_mtx);
+
+    // Reuse the sink if some logger is still using it.
+    std::weak_ptr<sink_t> &entry = m_stream_sinks[stream];
+    sink_ptr_t sink              = entry.lock();
+    if (!sink) {
+        sink  = std::make_shared<ostream_sink_t>(stream);
+        entry = sink;
+    }
+    return sink;
+}
+
+void registry_t::flush_sinks()
+{
+    std::lock_guard<std::mutex> lock(sink_mtx);
+    for (sink_map_t::iterator it = m_sinks.begin(); it != m_sinks.end(); ++it) {
+        it->second->flush();
+    }
+    for (stream_sink_map_t::iterator it = m_stream_sinks.begin(); it != m_stream_sinks.end();) {
+        sink_ptr_t sink = it->second.lock();
+        if (sink) {
+            sink->flush();
+            ++it;
+        } else {
+            // Nobody is using the sink anymore.
+            it = m_stream_sinks.erase(it);
+        }
+    }
+}
+
+void registry_t::warmup_all(std::size_t message_size)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (iterator it = m_map.begin(); it != m_map.end(); ++it) {
+            it->second.warmup(message_size);
+        }
+    }
+    std::lock_guard<std::mutex> lock(sink_mtx);
+    for (sink_map_t::iterator it = m_sinks.begin(); it != m_sinks.end(); ++it) {
+        it->second->warmup();
+    }
+    for (stream_sink_map_t::iterator it = m_stream_sinks.begin(); it != m_stream_sinks.end(); ++it) {
+        sink_ptr_t sink = it->second.lock();
+        if (sink) {
+            sink->warmup();
+        }
+    }
+}
+
 } // namespace quire
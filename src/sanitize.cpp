@@ -0,0 +1,131 @@
+/// @file sanitize.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include "quire/sanitize.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace quire
+{
+
+/// @brief Checks if the byte must be rewritten.
+static inline bool __is_unsafe(unsigned char c)
+{
+    return ((c < 0x20) && (c != '\t')) || (c >= 0x7F);
+}
+
+/// @brief Returns the length of the valid UTF-8 sequence starting the text,
+/// or zero if the sequence is not valid.
+static inline std::size_t __utf8_length(const unsigned char *text, std::size_t length)
+{
+    const unsigned char c = text[0];
+    std::size_t expected  = 0;
+    // The lowest code point of the sequence, to reject overlong encodings.
+    unsigned long lowest     = 0;
+    unsigned long code_point = 0;
+    if ((c >= 0xC2) && (c <= 0xDF)) {
+        expected   = 2;
+        lowest     = 0x80;
+        code_point = c & 0x1F;
+    } else if ((c >= 0xE0) && (c <= 0xEF)) {
+        expected   = 3;
+        lowest     = 0x800;
+        code_point = c & 0x0F;
+    } else if ((c >= 0xF0) && (c <= 0xF4)) {
+        expected   = 4;
+        lowest     = 0x10000;
+        code_point = c & 0x07;
+    } else {
+        return 0;
+    }
+    if (length < expected) {
+        return 0;
+    }
+    for (std::size_t i = 1; i < expected; ++i) {
+        if ((text[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        code_point = (code_point << 6) | (text[i] & 0x3F);
+    }
+    // Reject overlong encodings, surrogates, and code points beyond Unicode.
+    if ((code_point < lowest) || ((code_point >= 0xD800) && (code_point <= 0xDFFF)) || (code_point > 0x10FFFF)) {
+        return 0;
+    }
+    return expected;
+}
+
+std::size_t find_unsafe(const char *text, std::size_t length)
+{
+    std::size_t position = 0;
+#if defined(__SSE2__)
+    // Sixteen bytes at once: as signed bytes, the control characters and
+    // the bytes beyond ASCII are both lower than 0x20.
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i del   = _mm_set1_epi8(0x7F);
+    const __m128i tab   = _mm_set1_epi8('\t');
+    for (; position + 16 <= length; position += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + position));
+        const __m128i low   = _mm_andnot_si128(_mm_cmpeq_epi8(chunk, tab), _mm_cmplt_epi8(chunk, space));
+        const int mask      = _mm_movemask_epi8(_mm_or_si128(low, _mm_cmpeq_epi8(chunk, del)));
+        if (mask != 0) {
+            return position + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+#endif
+    for (; position < length; ++position) {
+        if (__is_unsafe(static_cast<unsigned char>(text[position]))) {
+            return position;
+        }
+    }
+    return length;
+}
+
+bool sanitize(const char *text, std::size_t length, std::string &out)
+{
+    // The newline ending the text terminates the line, it is kept.
+    const std::size_t body = ((length > 0) && (text[length - 1] == '\n')) ? length - 1 : length;
+
+    std::size_t position = find_unsafe(text, body);
+    if (position == body) {
+        return false;
+    }
+    out.clear();
+    out.reserve(length + 16);
+    out.append(text, position);
+    while (position < body) {
+        const unsigned char c = static_cast<unsigned char>(text[position]);
+        if (c >= 0x80) {
+            const std::size_t sequence = __utf8_length(reinterpret_cast<const unsigned char *>(text + position), body - position);
+            if (sequence > 0) {
+                out.append(text + position, sequence);
+                position += sequence;
+            } else {
+                // The replacement character, U+FFFD.
+                out.append("\xEF\xBF\xBD");
+                position += 1;
+            }
+        } else {
+            static const char digits[] = "0123456789abcdef";
+            if (c == '\n') {
+                out.append("\\n");
+            } else if (c == '\r') {
+                out.append("\\r");
+            } else {
+                const char escaped[4] = { '\\', 'x', digits[c >> 4], digits[c & 0x0F] };
+                out.append(escaped, 4);
+            }
+            position += 1;
+        }
+        // Copy the safe bytes that follow at once.
+        const std::size_t safe = find_unsafe(text + position, body - position);
+        out.append(text + position, safe);
+        position += safe;
+    }
+    out.append(text + body, length - body);
+    return true;
+}
+
+} // namespace quire
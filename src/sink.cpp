@@ -0,0 +1,463 @@
+/// @file sink.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include "quire/sink.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace quire
+{
+
+sink_t::sink_t() noexcept
+    : mtx(),
+      buffer(),
+      buffer_capacity(0),
+      flush_level(debug),
+      max_latency(0),
+      buffered_since(),
+      dirty(false),
+      record(),
+      record_text(),
+      record_start(0),
+      record_streamed(false)
+{
+    // Nothing to do.
+}
+
+sink_t::~sink_t()
+{
+    // Nothing to do, derived classes flush before their device goes away.
+}
+
+void sink_t::write(const line_t &line)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    if ((max_latency.count() > 0) && buffer.empty()) {
+        buffered_since = std::chrono::steady_clock::now();
+    }
+    this->append_line(buffer, line);
+
+    // Apply the flush policy.
+    if ((line.level >= flush_level) || this->is_late()) {
+        this->drain(true);
+    } else if (buffer.size() >= buffer_capacity) {
+        this->drain(false);
+    }
+}
+
+void sink_t::append_line(std::string &out, const line_t &line)
+{
+    // == COLOR (ON) ==========================================================
+    if (line.fg != nullptr) {
+        if (line.bg != nullptr) {
+            out.append(line.bg);
+        }
+        out.append(line.fg);
+    }
+
+    // == LINE ================================================================
+    out.append(line.text, line.length);
+
+    // == COLOR (OFF) =========================================================
+    if (line.fg != nullptr) {
+        out.append(ansi::util::reset);
+    }
+}
+
+void sink_t::flush()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    this->drain(true);
+}
+
+void sink_t::warmup()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    // Lines are appended one at a time, so even an unbuffered sink holds one.
+    const std::size_t size = std::max<std::size_t>(buffer_capacity, 4096U);
+    if (buffer.empty() && (buffer.capacity() < size)) {
+        // Writing the whole buffer makes the kernel map its pages now.
+        buffer.assign(size, '\0');
+        buffer.clear();
+    }
+}
+
+void sink_t::begin_record(const line_t &line)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    record          = line;
+    record_streamed = false;
+    if ((max_latency.count() > 0) && buffer.empty()) {
+        buffered_since = std::chrono::steady_clock::now();
+    }
+    if (this->streams_records()) {
+        // The record is assembled in the buffer, after the lines preceding
+        // it, so that it reaches the device with a single write.
+        line_t prefix = line;
+        prefix.length = line.prefix_length;
+        record_start  = buffer.size();
+        this->append_line(buffer, prefix);
+        // The colors are reset by end_record, after the chunks.
+        if (line.fg != nullptr) {
+            buffer.resize(buffer.size() - std::strlen(ansi::util::reset));
+        }
+    } else {
+        record_text.assign(line.text, line.prefix_length);
+    }
+    // The sink stays locked until end_record.
+    lock.release();
+}
+
+void sink_t::append_record(const char *data, std::size_t length)
+{
+    if (!this->streams_records()) {
+        record_text.append(data, length);
+        return;
+    }
+    if (!record_streamed) {
+        // The whole buffer is written at once only within the limit, with
+        // the color reset that end_record appends.
+        std::size_t size = buffer.size() + length + ((record.fg != nullptr) ? std::strlen(ansi::util::reset) : 0);
+        if ((size > this->record_limit()) && (record_start > 0)) {
+            // The lines preceding the record go first, so that the device
+            // never splits the buffer inside the record.
+            this->write_device(buffer.data(), record_start);
+            buffer.erase(0, record_start);
+            size -= record_start;
+            record_start = 0;
+            dirty        = true;
+        }
+        if (size <= this->record_limit()) {
+            buffer.append(data, length);
+            return;
+        }
+        // The record is too long to be written at once, it is written as
+        // its chunks arrive.
+        record_streamed = true;
+        this->drain(false);
+    }
+    const std::size_t chunk_size = std::max<std::size_t>(buffer_capacity, 4096U);
+    if (length >= chunk_size) {
+        // Write what precedes the chunk, then the chunk straight from the caller.
+        this->drain(false);
+        this->write_device(data, length);
+        dirty = true;
+    } else {
+        buffer.append(data, length);
+        if (buffer.size() >= chunk_size) {
+            this->drain(false);
+        }
+    }
+}
+
+void sink_t::end_record()
+{
+    // Unlock the sink, even if the device fails.
+    std::unique_lock<std::mutex> lock(mtx, std::adopt_lock);
+
+    if (this->streams_records()) {
+        if (record.fg != nullptr) {
+            buffer.append(ansi::util::reset);
+        }
+    } else {
+        record.text   = record_text.data();
+        record.length = record_text.size();
+        this->append_line(buffer, record);
+        record_text.clear();
+    }
+
+    // Apply the flush policy, the tail of a streamed record is never kept.
+    if ((record.level >= flush_level) || this->is_late()) {
+        this->drain(true);
+    } else if (record_streamed || (buffer.size() >= buffer_capacity)) {
+        this->drain(false);
+    }
+    record_streamed = false;
+}
+
+bool sink_t::streams_records() const
+{
+    return true;
+}
+
+std::size_t sink_t::record_limit() const
+{
+    return std::max<std::size_t>(buffer_capacity, 65536U);
+}
+
+sink_t &sink_t::set_buffer_capacity(std::size_t _capacity)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    buffer_capacity = _capacity;
+    buffer.reserve(buffer_capacity);
+    return *this;
+}
+
+sink_t &sink_t::set_flush_level(log_level _level)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    flush_level = _level;
+    return *this;
+}
+
+sink_t &sink_t::set_max_latency(std::chrono::milliseconds _max_latency)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    max_latency = _max_latency;
+    if (!buffer.empty()) {
+        buffered_since = std::chrono::steady_clock::now();
+    }
+    return *this;
+}
+
+void sink_t::drain(bool force_flush)
+{
+    if (!buffer.empty()) {
+        this->write_device(buffer.data(), buffer.size());
+        buffer.clear();
+        dirty = true;
+    }
+    // We only touch the device if we wrote something since the last flush.
+    // The device can set the flag again, if it still holds data.
+    if (force_flush && dirty) {
+        dirty = false;
+        this->flush_device();
+    }
+}
+
+bool sink_t::is_late() const
+{
+    return (max_latency.count() > 0) && !buffer.empty() && ((std::chrono::steady_clock::now() - buffered_since) >= max_latency);
+}
+
+ostream_sink_t::ostream_sink_t(std::ostream *_stream) noexcept
+    : sink_t(),
+      stream(_stream)
+{
+    // Nothing to do.
+}
+
+ostream_sink_t::~ostream_sink_t()
+{
+    this->flush();
+}
+
+std::ostream *ostream_sink_t::get_stream() const
+{
+    return stream;
+}
+
+void ostream_sink_t::write_device(const char *data, std::size_t length)
+{
+    if (stream) {
+        stream->write(data, static_cast<std::streamsize>(length));
+    }
+}
+
+void ostream_sink_t::flush_device()
+{
+    if (stream) {
+        stream->flush();
+    }
+}
+
+file_sink_t::file_sink_t(const std::string &_path, std::size_t _atomic_write_size)
+    : sink_t(),
+      path(_path),
+      fd(-1),
+      atomic_write_size(_atomic_write_size > 0 ? _atomic_write_size : 1),
+      index_fd(-1),
+      index_interval(0),
+      next_index_offset(0),
+      line_times()
+{
+#ifdef _WIN32
+    fd = ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+    if (fd < 0) {
+        throw quire::sink_exception_t("Failed to open `" + path + "`: " + std::strerror(errno));
+    }
+}
+
+file_sink_t::~file_sink_t()
+{
+    this->flush();
+#ifdef _WIN32
+    ::_close(fd);
+    if (index_fd >= 0) {
+        ::_close(index_fd);
+    }
+#else
+    ::close(fd);
+    if (index_fd >= 0) {
+        ::close(index_fd);
+    }
+#endif
+}
+
+const std::string &file_sink_t::get_path() const
+{
+    return path;
+}
+
+file_sink_t &file_sink_t::set_atomic_write_size(std::size_t _atomic_write_size)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    atomic_write_size = _atomic_write_size > 0 ? _atomic_write_size : 1;
+    return *this;
+}
+
+file_sink_t &file_sink_t::set_time_index(std::size_t interval)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if ((interval > 0) && (index_fd < 0)) {
+        const std::string index_path = path + ".idx";
+#ifdef _WIN32
+        index_fd = ::_open(index_path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        index_fd = ::open(index_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+        if (index_fd < 0) {
+            throw quire::sink_exception_t("Failed to open `" + index_path + "`: " + std::strerror(errno));
+        }
+    } else if ((interval == 0) && (index_fd >= 0)) {
+#ifdef _WIN32
+        ::_close(index_fd);
+#else
+        ::close(index_fd);
+#endif
+        index_fd = -1;
+    }
+    index_interval    = interval;
+    next_index_offset = 0;
+    return *this;
+}
+
+void file_sink_t::append_line(std::string &out, const line_t &line)
+{
+    if (index_fd >= 0) {
+        const std::chrono::system_clock::duration now = std::chrono::system_clock::now().time_since_epoch();
+        line_times.emplace_back(out.size(), std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+    }
+    sink_t::append_line(out, line);
+}
+
+void file_sink_t::write_device(const char *data, std::size_t length)
+{
+    // Position of the chunk inside the buffer, and of its first line inside `line_times`.
+    std::size_t position = 0, line = 0;
+
+    // The buffer only contains complete lines, or the start of a record too
+    // long to be written at once, we write as many lines as possible with
+    // each call, without ever splitting one.
+    while (length > 0) {
+        std::size_t chunk = length;
+        if (chunk > atomic_write_size) {
+            // Stop after the last newline that fits.
+            chunk = atomic_write_size;
+            while ((chunk > 0) && (data[chunk - 1] != '\n')) {
+                --chunk;
+            }
+            // The first line alone is too long, write it up to its end.
+            if (chunk == 0) {
+                const void *newline = std::memchr(data + atomic_write_size, '\n', length - atomic_write_size);
+                chunk               = newline ? static_cast<std::size_t>(static_cast<const char *>(newline) - data) + 1 : length;
+            }
+        }
+        const bool written = file_sink_t::write_all(fd, data, chunk);
+        if (written && (index_fd >= 0)) {
+            while ((line < line_times.size()) && (line_times[line].first < position)) {
+                ++line;
+            }
+            if ((line < line_times.size()) && (line_times[line].first < (position + chunk))) {
+                this->index_chunk(line_times[line].second, chunk);
+            }
+        }
+        data += chunk;
+        length -= chunk;
+        position += chunk;
+    }
+
+    // The data is the start of the buffer, which is then erased, the lines
+    // that follow it move to the front.
+    std::size_t written = 0;
+    while ((written < line_times.size()) && (line_times[written].first < position)) {
+        ++written;
+    }
+    line_times.erase(line_times.begin(), line_times.begin() + static_cast<std::ptrdiff_t>(written));
+    for (std::size_t i = 0; i < line_times.size(); ++i) {
+        line_times[i].first -= position;
+    }
+}
+
+std::size_t file_sink_t::record_limit() const
+{
+    return atomic_write_size;
+}
+
+void file_sink_t::flush_device()
+{
+    // Nothing to do, every write goes straight to the kernel.
+}
+
+bool file_sink_t::write_all(int descriptor, const char *data, std::size_t length)
+{
+    while (length > 0) {
+#ifdef _WIN32
+        const long written = ::_write(descriptor, data, static_cast<unsigned>(length));
+#else
+        const long written = static_cast<long>(::write(descriptor, data, length));
+#endif
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Logging must never stop the caller, we drop the data.
+            return false;
+        }
+        data += written;
+        length -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+void file_sink_t::index_chunk(std::int64_t time, std::size_t length)
+{
+    // In append mode, the file position is the end of what we just wrote,
+    // even when other processes append to the same file.
+#ifdef _WIN32
+    const long long end = ::_lseeki64(fd, 0, SEEK_CUR);
+#else
+    const long long end = static_cast<long long>(::lseek(fd, 0, SEEK_CUR));
+#endif
+    if (end < static_cast<long long>(length)) {
+        return;
+    }
+    const std::uint64_t start = static_cast<std::uint64_t>(end) - length;
+    if (start < next_index_offset) {
+        return;
+    }
+    // A single small write, so entries of different processes never interleave.
+    const time_index_entry_t entry = { time, start };
+    if (file_sink_t::write_all(index_fd, reinterpret_cast<const char *>(&entry), sizeof(entry))) {
+        next_index_offset = start + index_interval;
+    }
+}
+
+} // namespace quire
@@ -0,0 +1,404 @@
+/// @file site.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include "quire/site.hpp"
+
+#include <cstring>
+
+#ifdef QUIRE_HAS_STATIC_KEYS
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include <atomic>
+#endif
+
+namespace quire
+{
+
+void site_t::attach()
+{
+    site_registry_t::instance().attach(*this);
+}
+
+site_filter_t::site_filter_t()
+    : file(),
+      first_line(0),
+      last_line(INT_MAX),
+      format()
+{
+    // Nothing to do.
+}
+
+site_filter_t &site_filter_t::in_file(const std::string &_file)
+{
+    file = _file;
+    return *this;
+}
+
+site_filter_t &site_filter_t::in_lines(int _first_line, int _last_line)
+{
+    first_line = _first_line;
+    last_line  = _last_line;
+    return *this;
+}
+
+site_filter_t &site_filter_t::with_format(const std::string &_format)
+{
+    format = _format;
+    return *this;
+}
+
+bool site_filter_t::matches(const site_t &site) const
+{
+    if ((site.get_line() < first_line) || (site.get_line() > last_line)) {
+        return false;
+    }
+    if (!file.empty()) {
+        const std::size_t length = std::strlen(site.get_file());
+        if ((length < file.length()) || (file.compare(0, file.length(), site.get_file() + length - file.length()) != 0)) {
+            return false;
+        }
+    }
+    if (!format.empty()) {
+        if ((site.get_format() == nullptr) || (std::strstr(site.get_format(), format.c_str()) == nullptr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool site_filter_t::operator==(const site_filter_t &other) const
+{
+    return (file == other.file) && (first_line == other.first_line) && (last_line == other.last_line) && (format == other.format);
+}
+
+site_registry_t::site_registry_t()
+    : rules(),
+      head(nullptr),
+      mtx()
+#ifdef QUIRE_HAS_STATIC_KEYS
+      ,
+      jump_tables(),
+      level_refs()
+#endif
+{
+    // Nothing to do.
+}
+
+std::size_t site_registry_t::set_state(const site_filter_t &filter, site_t::state_t state)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    // A rule with the same filter replaces the previous one.
+    for (std::size_t i = 0; i < rules.size(); ++i) {
+        if (rules[i].first == filter) {
+            rules.erase(rules.begin() + static_cast<std::ptrdiff_t>(i));
+            break;
+        }
+    }
+    rules.emplace_back(filter, state);
+
+    std::size_t matched = 0;
+    for (site_t *site = head; site != nullptr; site = site->next) {
+        if (filter.matches(*site)) {
+            site->state.store(state, std::memory_order_relaxed);
+            ++matched;
+        }
+    }
+#ifdef QUIRE_HAS_STATIC_KEYS
+    this->patch_sites();
+#endif
+    return matched;
+}
+
+std::vector<const site_t *> site_registry_t::get_sites() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<const site_t *> sites;
+    for (const site_t *site = head; site != nullptr; site = site->next) {
+        sites.emplace_back(site);
+    }
+    return sites;
+}
+
+void site_registry_t::attach(site_t &site)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    // Another thread may have attached it in the meantime.
+    if (site.state.load(std::memory_order_relaxed) != site_t::unregistered) {
+        return;
+    }
+    site.next = head;
+    head      = &site;
+
+    site_t::state_t state = site_t::inherit;
+    for (std::size_t i = 0; i < rules.size(); ++i) {
+        if (rules[i].first.matches(site)) {
+            state = rules[i].second;
+        }
+    }
+    site.state.store(state, std::memory_order_relaxed);
+}
+
+#ifdef QUIRE_HAS_STATIC_KEYS
+
+/// @brief A site whose instruction changes.
+struct patch_t {
+    std::uintptr_t code;    ///< Address of the instruction.
+    unsigned char bytes[5]; ///< The new instruction.
+};
+
+#if defined(__x86_64__)
+/// @brief Size of the instruction of a site, a jump or a NOP.
+static const std::size_t __instruction_size = 5;
+/// @brief The breakpoint instruction, int3.
+static const unsigned char __breakpoint = 0xCC;
+/// @brief Set while the sites are being patched.
+static std::atomic<bool> __patching(false);
+/// @brief The handler of SIGTRAP before ours, for the breakpoints that are not ours.
+static struct sigaction __previous_trap;
+
+/// @brief Handles the breakpoints placed on the sites while they are patched,
+/// by waiting for the patch to complete, and executing the site again.
+/// @details A site is aligned to 8 bytes and, once patched, starts with
+/// either a jump or a NOP; any other breakpoint goes to the previous handler.
+static void __breakpoint_handler(int signal, siginfo_t *info, void *context)
+{
+    ucontext_t *ucontext               = static_cast<ucontext_t *>(context);
+    const std::uintptr_t address       = static_cast<std::uintptr_t>(ucontext->uc_mcontext.gregs[REG_RIP]) - 1;
+    const volatile unsigned char *code = reinterpret_cast<const volatile unsigned char *>(address);
+    if ((address % 8) == 0) {
+        if (__patching.load(std::memory_order_acquire)) {
+            while (__patching.load(std::memory_order_acquire) && (*code == __breakpoint)) {
+                __builtin_ia32_pause();
+            }
+            // If it was not ours, it traps again.
+            ucontext->uc_mcontext.gregs[REG_RIP] = static_cast<greg_t>(address);
+            return;
+        }
+        if ((*code == 0xE9) || (*code == 0x0F)) {
+            // The patch completed while the signal was delivered.
+            ucontext->uc_mcontext.gregs[REG_RIP] = static_cast<greg_t>(address);
+            return;
+        }
+    }
+    if (__previous_trap.sa_flags & SA_SIGINFO) {
+        __previous_trap.sa_sigaction(signal, info, context);
+    } else if (__previous_trap.sa_handler == SIG_DFL) {
+        // The breakpoint traps again, and the default action follows.
+        ::sigaction(SIGTRAP, &__previous_trap, nullptr);
+        ucontext->uc_mcontext.gregs[REG_RIP] = static_cast<greg_t>(address);
+    } else if (__previous_trap.sa_handler != SIG_IGN) {
+        __previous_trap.sa_handler(signal);
+    }
+}
+
+/// @brief Installs the handler of the breakpoints, once.
+/// @return true if it is installed.
+static inline bool __install_breakpoint_handler()
+{
+    static bool installed = false;
+    if (!installed) {
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_sigaction = __breakpoint_handler;
+        action.sa_flags     = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        installed = ::sigaction(SIGTRAP, &action, &__previous_trap) == 0;
+    }
+    return installed;
+}
+#else
+/// @brief Size of the instruction of a site, a branch or a NOP.
+static const std::size_t __instruction_size = 4;
+#endif
+
+/// @brief Encodes the instruction of a site, as a jump to its target or as a NOP.
+static inline void __encode_site(unsigned char *bytes, std::uintptr_t code, std::uintptr_t target, bool live)
+{
+#if defined(__x86_64__)
+    if (live) {
+        const std::int32_t offset = static_cast<std::int32_t>(target - (code + 5));
+        bytes[0]                  = 0xE9;
+        std::memcpy(bytes + 1, &offset, sizeof(offset));
+    } else {
+        const unsigned char nop[5] = { 0x0F, 0x1F, 0x44, 0x00, 0x00 };
+        std::memcpy(bytes, nop, sizeof(nop));
+    }
+#else
+    const std::uint32_t instruction = live ? (0x14000000U | (static_cast<std::uint32_t>(static_cast<std::int64_t>(target - code) >> 2) & 0x03FFFFFFU)) : 0xD503201FU;
+    std::memcpy(bytes, &instruction, sizeof(instruction));
+#endif
+}
+
+/// @brief Makes the page of the instruction writable, or only executable again.
+/// @return true on success.
+static inline bool __protect_code(std::uintptr_t code, bool writable)
+{
+    // Instructions are aligned, they never cross a page.
+    const std::uintptr_t page_size = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+    void *page                     = reinterpret_cast<void *>(code & ~(page_size - 1));
+    return ::mprotect(page, page_size, PROT_READ | PROT_EXEC | (writable ? PROT_WRITE : 0)) == 0;
+}
+
+/// @brief Makes sure every thread executes the patched code.
+static inline void __sync_cores()
+{
+#ifdef MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE
+    static const bool registered = ::syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_SYNC_CORE, 0) == 0;
+    if (registered) {
+        ::syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE, 0);
+    }
+#endif
+}
+
+/// @brief Rewrites the instructions of the sites, while other threads may
+/// be executing them.
+/// @details On x86-64 this follows the protocol for cross-modifying code of
+/// the Intel SDM, for all the sites at once: a breakpoint replaces the first
+/// byte, then the cores are synchronized, then the rest of the instruction
+/// is written, then the cores are synchronized, then the first byte is
+/// written, then the cores are synchronized again. A thread hitting a
+/// breakpoint waits in the SIGTRAP handler, which must not be replaced
+/// afterwards, and executes the site again once patched; if the handler
+/// cannot be installed the sites are left as they are. On AArch64 a branch
+/// and a NOP can be exchanged with a single aligned 4-byte store while other
+/// cores execute them, as the architecture allows, followed by a sync.
+/// @param patches The sites, and their new instructions.
+static inline void __patch_code(std::vector<patch_t> &patches)
+{
+    for (std::size_t i = 0; i < patches.size();) {
+        if (__protect_code(patches[i].code, true)) {
+            ++i;
+        } else {
+            patches.erase(patches.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+    }
+#if defined(__x86_64__)
+    if (__install_breakpoint_handler()) {
+        __patching.store(true, std::memory_order_release);
+        for (std::size_t i = 0; i < patches.size(); ++i) {
+            __atomic_store_n(reinterpret_cast<unsigned char *>(patches[i].code), __breakpoint, __ATOMIC_SEQ_CST);
+        }
+        __sync_cores();
+        for (std::size_t i = 0; i < patches.size(); ++i) {
+            for (std::size_t j = 1; j < __instruction_size; ++j) {
+                __atomic_store_n(reinterpret_cast<unsigned char *>(patches[i].code + j), patches[i].bytes[j], __ATOMIC_RELAXED);
+            }
+        }
+        __sync_cores();
+        for (std::size_t i = 0; i < patches.size(); ++i) {
+            __atomic_store_n(reinterpret_cast<unsigned char *>(patches[i].code), patches[i].bytes[0], __ATOMIC_SEQ_CST);
+        }
+        __sync_cores();
+        __patching.store(false, std::memory_order_release);
+    }
+#else
+    for (std::size_t i = 0; i < patches.size(); ++i) {
+        std::uint32_t instruction;
+        std::memcpy(&instruction, patches[i].bytes, sizeof(instruction));
+        __atomic_store_n(reinterpret_cast<std::uint32_t *>(patches[i].code), instruction, __ATOMIC_SEQ_CST);
+        __builtin___clear_cache(reinterpret_cast<char *>(patches[i].code), reinterpret_cast<char *>(patches[i].code + 4));
+    }
+    __sync_cores();
+#endif
+    for (std::size_t i = 0; i < patches.size(); ++i) {
+        __protect_code(patches[i].code, false);
+    }
+}
+
+namespace detail
+{
+int register_jump_table(jump_entry_t *first, jump_entry_t *last)
+{
+    if ((first != nullptr) && (first != last)) {
+        site_registry_t::instance().add_jump_table(first, last);
+    }
+    return 0;
+}
+} // namespace detail
+
+void site_registry_t::add_jump_table(detail::jump_entry_t *first, detail::jump_entry_t *last)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    // Every translation unit of a binary registers the same table.
+    for (std::size_t i = 0; i < jump_tables.size(); ++i) {
+        if (jump_tables[i].first == first) {
+            return;
+        }
+    }
+    jump_tables.emplace_back(first, last);
+
+    // Sites that are never executed would never attach themselves.
+    for (detail::jump_entry_t *entry = first; entry != last; ++entry) {
+        site_t &site = *entry->site;
+        if (site.state.load(std::memory_order_relaxed) == site_t::unregistered) {
+            site.next = head;
+            head      = &site;
+            site_t::state_t state = site_t::inherit;
+            for (std::size_t i = 0; i < rules.size(); ++i) {
+                if (rules[i].first.matches(site)) {
+                    state = rules[i].second;
+                }
+            }
+            site.state.store(state, std::memory_order_relaxed);
+        }
+    }
+    this->patch_sites();
+}
+
+void site_registry_t::retain_level(log_level level)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    bool changed = false;
+    for (int i = level; i <= critical; ++i) {
+        changed |= (level_refs[i]++ == 0);
+    }
+    if (changed) {
+        this->patch_sites();
+    }
+}
+
+void site_registry_t::release_level(log_level level)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    bool changed = false;
+    for (int i = level; i <= critical; ++i) {
+        changed |= (--level_refs[i] == 0);
+    }
+    if (changed) {
+        this->patch_sites();
+    }
+}
+
+void site_registry_t::patch_sites()
+{
+    std::vector<patch_t> patches;
+    for (std::size_t i = 0; i < jump_tables.size(); ++i) {
+        for (detail::jump_entry_t *entry = jump_tables[i].first; entry != jump_tables[i].second; ++entry) {
+            const site_t &site          = *entry->site;
+            const site_t::state_t state = site.get_state();
+            const bool live             = (state == site_t::enabled) || ((state != site_t::disabled) && (level_refs[site.get_level()] > 0));
+            patch_t patch;
+            patch.code = entry->code;
+            __encode_site(patch.bytes, entry->code, entry->target, live);
+            if (std::memcmp(reinterpret_cast<const void *>(entry->code), patch.bytes, __instruction_size) != 0) {
+                patches.emplace_back(patch);
+            }
+        }
+    }
+    if (!patches.empty()) {
+        __patch_code(patches);
+    }
+}
+
+#endif
+
+} // namespace quire
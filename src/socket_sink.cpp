@@ -0,0 +1,245 @@
+/// @file socket_sink.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include "quire/socket_sink.hpp"
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__unix__)
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#ifdef MSG_NOSIGNAL
+#define QUIRE_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define QUIRE_SEND_FLAGS 0
+#endif
+
+namespace quire
+{
+
+socket_sink_t::socket_sink_t(const std::string &_path)
+    : sink_t(),
+      domain(AF_UNIX),
+      path(_path),
+      address(),
+      port(0),
+      fd(-1),
+      state(state_t::disconnected),
+      pending(),
+      pending_start(0),
+      torn(false),
+      max_pending_size(4U << 20U),
+      pending_size(0),
+      dropped(0),
+      min_backoff(100),
+      max_backoff(5000),
+      backoff(100),
+      next_attempt()
+{
+    // Coalesce the lines, and send them when the buffer is full, when they
+    // waited too long, or when an error is written.
+    buffer_capacity = 65536;
+    flush_level     = error;
+    max_latency     = std::chrono::milliseconds(100);
+}
+
+socket_sink_t::socket_sink_t(const std::string &_address, unsigned short _port)
+    : socket_sink_t(std::string())
+{
+    in_addr parsed;
+    if (::inet_pton(AF_INET, _address.c_str(), &parsed) != 1) {
+        throw quire::sink_exception_t("Invalid IPv4 address `" + _address + "`.");
+    }
+    domain  = AF_INET;
+    address = _address;
+    port    = _port;
+}
+
+socket_sink_t::~socket_sink_t()
+{
+    this->flush();
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+bool socket_sink_t::is_connected() const
+{
+    return state.load() == state_t::connected;
+}
+
+std::size_t socket_sink_t::get_dropped() const
+{
+    return dropped.load();
+}
+
+std::size_t socket_sink_t::get_pending_size() const
+{
+    return pending_size.load();
+}
+
+socket_sink_t &socket_sink_t::set_max_pending_size(std::size_t _max_pending_size)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    max_pending_size = _max_pending_size;
+    return *this;
+}
+
+socket_sink_t &socket_sink_t::set_reconnect_backoff(std::chrono::milliseconds _min_backoff, std::chrono::milliseconds _max_backoff)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    min_backoff = _min_backoff;
+    max_backoff = std::max(_min_backoff, _max_backoff);
+    backoff     = min_backoff;
+    return *this;
+}
+
+std::size_t socket_sink_t::record_limit() const
+{
+    return max_pending_size;
+}
+
+void socket_sink_t::write_device(const char *data, std::size_t length)
+{
+    // The buffer of the sink only holds whole lines, so we either keep all of
+    // them, or drop all of them. A record written as its chunks arrive could
+    // never be kept whole, so it is dropped.
+    if (record_streamed || ((pending.size() - pending_start + length) > max_pending_size)) {
+        dropped += length;
+    } else {
+        pending.append(data, length);
+    }
+    this->send_pending();
+}
+
+void socket_sink_t::flush_device()
+{
+    this->send_pending();
+    // Try again at the next flush.
+    dirty = pending_start < pending.size();
+}
+
+bool socket_sink_t::connect()
+{
+    if (state == state_t::connected) {
+        return true;
+    }
+    if (state == state_t::disconnected) {
+        if (std::chrono::steady_clock::now() < next_attempt) {
+            return false;
+        }
+        fd = ::socket(domain, SOCK_STREAM, 0);
+        if (fd < 0) {
+            this->disconnect();
+            return false;
+        }
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        int result;
+        if (domain == AF_UNIX) {
+            sockaddr_un target;
+            std::memset(&target, 0, sizeof(target));
+            target.sun_family = AF_UNIX;
+            std::strncpy(target.sun_path, path.c_str(), sizeof(target.sun_path) - 1);
+            result = ::connect(fd, reinterpret_cast<const sockaddr *>(&target), sizeof(target));
+        } else {
+            sockaddr_in target;
+            std::memset(&target, 0, sizeof(target));
+            target.sin_family = AF_INET;
+            target.sin_port   = htons(port);
+            ::inet_pton(AF_INET, address.c_str(), &target.sin_addr);
+            result = ::connect(fd, reinterpret_cast<const sockaddr *>(&target), sizeof(target));
+        }
+        if (result == 0) {
+            state   = state_t::connected;
+            backoff = min_backoff;
+            return true;
+        }
+        if ((errno != EINPROGRESS) && (errno != EINTR)) {
+            this->disconnect();
+            return false;
+        }
+        state = state_t::connecting;
+    }
+    // Check, without waiting, if the connection has been established.
+    pollfd descriptor = { fd, POLLOUT, 0 };
+    if (::poll(&descriptor, 1, 0) <= 0) {
+        return false;
+    }
+    int error           = 0;
+    socklen_t error_len = sizeof(error);
+    if ((::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_len) != 0) || (error != 0)) {
+        this->disconnect();
+        return false;
+    }
+    state   = state_t::connected;
+    backoff = min_backoff;
+    return true;
+}
+
+void socket_sink_t::disconnect()
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    state        = state_t::disconnected;
+    next_attempt = std::chrono::steady_clock::now() + backoff;
+    backoff      = std::min(backoff * 2, max_backoff);
+
+    // A line sent in part would reach the collector torn, so we drop the rest of it.
+    if (torn) {
+        std::size_t end = pending.find('\n', pending_start);
+        end             = (end == std::string::npos) ? pending.size() : end + 1;
+        dropped += end - pending_start;
+        pending_start = end;
+        torn          = false;
+    }
+}
+
+void socket_sink_t::send_pending()
+{
+    while ((pending_start < pending.size()) && this->connect()) {
+        const ssize_t result = ::send(fd, pending.data() + pending_start, pending.size() - pending_start, QUIRE_SEND_FLAGS);
+        if (result > 0) {
+            pending_start += static_cast<std::size_t>(result);
+            torn = pending[pending_start - 1] != '\n';
+        } else if (result == 0) {
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            this->disconnect();
+        }
+    }
+
+    // Compact the outgoing buffer, once most of it has been sent.
+    if (pending_start == pending.size()) {
+        pending.clear();
+        pending_start = 0;
+    } else if (pending_start > (pending.size() / 2)) {
+        pending.erase(0, pending_start);
+        pending_start = 0;
+    }
+    pending_size = pending.size() - pending_start;
+}
+
+} // namespace quire
+
+#endif
@@ -0,0 +1,235 @@
+/// @file span.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include "quire/span.hpp"
+#include "quire/sink.hpp"
+#include "quire/lock.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace quire
+{
+
+namespace detail
+{
+/// @brief The spans recorded by a thread.
+struct span_buffer_t {
+    span_event_t events[tracer_t::buffer_capacity]; ///< The spans.
+    std::size_t count;                              ///< Number of spans.
+    unsigned tid;                                   ///< Identifier of the thread in the trace.
+    spin_lock_t lock;                               ///< Lock, taken by the thread and by flushes.
+
+    span_buffer_t()
+        : events(),
+          count(0),
+          tid(0),
+          lock()
+    {
+        tracer_t::instance().attach(this);
+    }
+
+    ~span_buffer_t()
+    {
+        tracer_t::instance().detach(this);
+    }
+};
+} // namespace detail
+
+/// @brief Appends the unsigned integer.
+static inline void __append_unsigned(std::string &out, std::uint64_t value)
+{
+    char digits[20];
+    std::size_t length = 0;
+    do {
+        digits[length++] = static_cast<char>('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+    while (length > 0) {
+        out.push_back(digits[--length]);
+    }
+}
+
+/// @brief Appends the nanoseconds as microseconds, with three decimals.
+static inline void __append_microseconds(std::string &out, std::int64_t nanoseconds)
+{
+    if (nanoseconds < 0) {
+        out.push_back('-');
+        nanoseconds = -nanoseconds;
+    }
+    const std::uint64_t value = static_cast<std::uint64_t>(nanoseconds);
+    __append_unsigned(out, value / 1000);
+    const unsigned fraction = static_cast<unsigned>(value % 1000);
+    out.push_back('.');
+    out.push_back(static_cast<char>('0' + fraction / 100));
+    out.push_back(static_cast<char>('0' + (fraction / 10) % 10));
+    out.push_back(static_cast<char>('0' + fraction % 10));
+}
+
+/// @brief Appends the string as the content of a JSON string.
+static inline void __append_json_string(std::string &out, const char *text)
+{
+    for (; *text != '\0'; ++text) {
+        const unsigned char c = static_cast<unsigned char>(*text);
+        if ((c == '"') || (c == '\\')) {
+            out.push_back('\\');
+            out.push_back(static_cast<char>(c));
+        } else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out.append(escaped);
+        } else {
+            out.push_back(static_cast<char>(c));
+        }
+    }
+}
+
+tracer_t::tracer_t()
+    : mtx(),
+      sink(),
+      tracing(false),
+      first_event(true),
+      buffers(),
+      next_tid(0),
+#ifdef _WIN32
+      pid(static_cast<long>(::_getpid())),
+#else
+      pid(static_cast<long>(::getpid())),
+#endif
+      json()
+{
+    // Nothing to do.
+}
+
+void tracer_t::start(std::shared_ptr<sink_t> _sink)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    // Spans recorded before the trace started are not part of it.
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+        std::lock_guard<spin_lock_t> buffer_lock(buffers[i]->lock);
+        buffers[i]->count = 0;
+    }
+    sink        = _sink;
+    first_event = true;
+    this->write_text("[\n");
+    tracing = true;
+}
+
+void tracer_t::stop()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!tracing) {
+        return;
+    }
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+        this->write_buffer(*buffers[i]);
+    }
+    tracing = false;
+    this->write_text("\n]\n");
+    sink->flush();
+    sink.reset();
+}
+
+void tracer_t::flush()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (tracing) {
+        for (std::size_t i = 0; i < buffers.size(); ++i) {
+            this->write_buffer(*buffers[i]);
+        }
+        sink->flush();
+    }
+}
+
+void tracer_t::record(const char *name, std::int64_t begin, std::int64_t end)
+{
+    // Allocated with the first span of the thread, then reused.
+    static thread_local std::unique_ptr<detail::span_buffer_t> buffer;
+    if (!buffer) {
+        buffer.reset(new detail::span_buffer_t());
+    }
+    std::unique_lock<spin_lock_t> buffer_lock(buffer->lock);
+    buffer->events[buffer->count++] = span_event_t{ name, begin, end };
+    if (buffer->count == buffer_capacity) {
+        buffer_lock.unlock();
+        std::lock_guard<std::mutex> lock(mtx);
+        this->write_buffer(*buffer);
+    }
+}
+
+void tracer_t::attach(detail::span_buffer_t *buffer)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    buffer->tid = ++next_tid;
+    buffers.emplace_back(buffer);
+}
+
+void tracer_t::detach(detail::span_buffer_t *buffer)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    this->write_buffer(*buffer);
+    buffers.erase(std::remove(buffers.begin(), buffers.end(), buffer), buffers.end());
+}
+
+void tracer_t::write_buffer(detail::span_buffer_t &buffer)
+{
+    std::lock_guard<spin_lock_t> buffer_lock(buffer.lock);
+    if (!tracing) {
+        buffer.count = 0;
+        return;
+    }
+    json.clear();
+    for (std::size_t i = 0; i < buffer.count; ++i) {
+        const span_event_t &event = buffer.events[i];
+        if (!first_event) {
+            json.append(",\n");
+        }
+        first_event = false;
+        json.append("{\"name\":\"");
+        __append_json_string(json, event.name);
+        json.append("\",\"cat\":\"span\",\"ph\":\"X\",\"ts\":");
+        __append_microseconds(json, event.begin);
+        json.append(",\"dur\":");
+        __append_microseconds(json, event.end - event.begin);
+        json.append(",\"pid\":");
+        __append_unsigned(json, static_cast<std::uint64_t>(pid));
+        json.append(",\"tid\":");
+        __append_unsigned(json, buffer.tid);
+        json.push_back('}');
+    }
+    buffer.count = 0;
+    if (!json.empty()) {
+        this->write_text(json);
+    }
+}
+
+void tracer_t::write_text(const std::string &text)
+{
+    if (sink) {
+        const line_t line = { debug, nullptr, nullptr, "", "", text.data(), text.size(), 0 };
+        sink->write(line);
+    }
+}
+
+void span_t::finish(std::int64_t end)
+{
+    if (mode == trace) {
+        tracer_t &tracer = tracer_t::instance();
+        if (tracer.is_tracing()) {
+            tracer.record(name, begin, end);
+        }
+    } else {
+        char message[256];
+        std::snprintf(message, sizeof(message), "%s took %.3f us\n", name, static_cast<double>(end - begin) / 1e3);
+        logger.log_message(debug, file, line, message);
+    }
+}
+
+} // namespace quire
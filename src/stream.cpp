@@ -0,0 +1,139 @@
+/// @file stream.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include "quire/stream.hpp"
+
+namespace quire
+{
+
+namespace detail
+{
+
+/// @brief How many records a thread can build at the same time, e.g., when
+/// the operator<< of an object logs something itself.
+static const std::size_t __max_stream_depth = 4;
+
+/// @brief The slots of the calling thread.
+struct stream_slots_t {
+    stream_slot_t slots[__max_stream_depth]; ///< The slots.
+    std::size_t depth;                       ///< How many slots are in use.
+
+    stream_slots_t()
+        : slots(),
+          depth(0)
+    {
+        // Nothing to do.
+    }
+};
+
+/// @brief Returns the slots of the calling thread.
+static inline stream_slots_t &__thread_slots()
+{
+    static thread_local stream_slots_t slots;
+    return slots;
+}
+
+fixed_streambuf_t::fixed_streambuf_t() noexcept
+    : std::streambuf(),
+      data(),
+      dropped(0)
+{
+    this->reset();
+}
+
+void fixed_streambuf_t::reset() noexcept
+{
+    // Keep two characters aside for the newline and the terminator.
+    this->setp(data, data + QUIRE_STREAM_BUFFER_SIZE);
+    dropped = 0;
+}
+
+const char *fixed_streambuf_t::terminate() noexcept
+{
+    char *end = this->pptr();
+    if ((end == data) || (*(end - 1) != '\n')) {
+        *end++ = '\n';
+    }
+    *end = '\0';
+    if (dropped > 0) {
+        // The buffer is full, the marker ends where the newline would go.
+        mark_truncated(data, QUIRE_STREAM_BUFFER_SIZE + 2, QUIRE_STREAM_BUFFER_SIZE + dropped, true);
+    }
+    return data;
+}
+
+fixed_streambuf_t::int_type fixed_streambuf_t::overflow(int_type ch)
+{
+    // Pretend the character was written, so the stream keeps counting.
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        ++dropped;
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize fixed_streambuf_t::xsputn(const char *s, std::streamsize n)
+{
+    const std::streamsize room  = this->epptr() - this->pptr();
+    const std::streamsize count = (n < room) ? n : room;
+    traits_type::copy(this->pptr(), s, static_cast<std::size_t>(count));
+    this->pbump(static_cast<int>(count));
+    dropped += static_cast<std::size_t>(n - count);
+    return n;
+}
+
+stream_slot_t::stream_slot_t()
+    : buffer(),
+      stream(&buffer)
+{
+    // Nothing to do.
+}
+
+} // namespace detail
+
+record_stream_t::record_stream_t(logger_base_t &_logger, log_level _level, const char *_file, int _line)
+    : slot(nullptr),
+      logger(_logger),
+      level(_level),
+      file(_file),
+      line(_line)
+{
+    detail::stream_slots_t &slots = detail::__thread_slots();
+    if (slots.depth < detail::__max_stream_depth) {
+        slot = &slots.slots[slots.depth];
+    } else {
+        // Too many nested records, this one gets its own slot.
+        slot = new detail::stream_slot_t();
+    }
+    ++slots.depth;
+
+    // Start from a clean buffer and the default formatting.
+    slot->buffer.reset();
+    slot->stream.clear();
+    slot->stream.flags(std::ios_base::skipws | std::ios_base::dec);
+    slot->stream.precision(6);
+    slot->stream.width(0);
+    slot->stream.fill(' ');
+}
+
+record_stream_t::~record_stream_t()
+{
+    // The slot is released even if a sink fails, and we cannot throw here.
+    try {
+        logger.log_message(level, file, line, slot->buffer.terminate());
+    } catch (...) {
+    }
+
+    detail::stream_slots_t &slots = detail::__thread_slots();
+    --slots.depth;
+    if (slots.depth >= detail::__max_stream_depth) {
+        delete slot;
+    }
+}
+
+std::ostream &record_stream_t::stream()
+{
+    return slot->stream;
+}
+
+} // namespace quire
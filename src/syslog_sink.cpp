@@ -0,0 +1,268 @@
+/// @file syslog_sink.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief
+
+#include "quire/syslog_sink.hpp"
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__unix__)
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <ctime>
+
+namespace quire
+{
+
+/// @brief Maps the log level to the syslog severity.
+static inline int __syslog_severity(log_level level)
+{
+    if (level == debug) {
+        return 7;
+    }
+    if (level == info) {
+        return 6;
+    }
+    if (level == warning) {
+        return 4;
+    }
+    if (level == error) {
+        return 3;
+    }
+    return 2;
+}
+
+syslog_sink_t::syslog_sink_t(const std::string &_socket_path, int _facility)
+    : sink_t(),
+      socket_path(_socket_path),
+      fd(-1),
+      facility(_facility),
+      hostname("-"),
+      procid(std::to_string(::getpid())),
+      max_record_size(8192),
+      entry_ends(),
+      backlog(),
+      backlog_ends(),
+      backlog_start(0),
+      max_backlog_size(1U << 20U),
+      backlog_size(0),
+      dropped(0)
+{
+    fd = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+    if ((fd < 0) ||
+        (::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) ||
+        (::fcntl(fd, F_SETFD, FD_CLOEXEC) != 0)) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw quire::sink_exception_t(std::string("Failed to create the syslog socket: ") + std::strerror(errno));
+    }
+
+    // The hostname does not change, we render it once.
+    char name[256];
+    if ((::gethostname(name, sizeof(name)) == 0) && (name[0] != '\0')) {
+        name[sizeof(name) - 1] = '\0';
+        hostname               = name;
+    }
+}
+
+syslog_sink_t::~syslog_sink_t()
+{
+    this->flush();
+    ::close(fd);
+}
+
+const std::string &syslog_sink_t::get_socket_path() const
+{
+    return socket_path;
+}
+
+std::size_t syslog_sink_t::get_dropped() const
+{
+    return dropped.load();
+}
+
+std::size_t syslog_sink_t::get_backlog_size() const
+{
+    return backlog_size.load();
+}
+
+syslog_sink_t &syslog_sink_t::set_max_backlog_size(std::size_t _max_backlog_size)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    max_backlog_size = _max_backlog_size;
+    return *this;
+}
+
+syslog_sink_t &syslog_sink_t::set_max_record_size(std::size_t _max_record_size)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    max_record_size = _max_record_size;
+    return *this;
+}
+
+bool syslog_sink_t::streams_records() const
+{
+    // Each record is a single message, it must be encoded as a whole.
+    return false;
+}
+
+void syslog_sink_t::append_line(std::string &out, const line_t &line)
+{
+    const std::size_t start = out.size();
+
+    // == PRI and VERSION =====================================================
+    char pri[16];
+    std::snprintf(pri, sizeof(pri), "<%d>1 ", facility * 8 + __syslog_severity(line.level));
+    out.append(pri);
+
+    // == TIMESTAMP ===========================================================
+    const std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+    const std::time_t seconds                       = std::chrono::system_clock::to_time_t(now);
+    const long long micros                          = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count() % 1000000;
+    std::tm utc;
+    ::gmtime_r(&seconds, &utc);
+    char timestamp[48];
+    std::size_t timestamp_length = std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", &utc);
+    std::snprintf(timestamp + timestamp_length, sizeof(timestamp) - timestamp_length, ".%06lldZ ", micros);
+    out.append(timestamp);
+
+    // == HOSTNAME ============================================================
+    out.append(hostname);
+    out.push_back(' ');
+
+    // == APP-NAME ============================================================
+    // Printable characters only, at most 48 of them.
+    std::size_t app_length = 0;
+    for (const char *c = line.header; (*c != '\0') && (app_length < 48); ++c) {
+        if ((*c > ' ') && (*c < 127)) {
+            out.push_back(*c);
+            ++app_length;
+        }
+    }
+    if (app_length == 0) {
+        out.push_back('-');
+    }
+    out.push_back(' ');
+
+    // == PROCID, MSGID and STRUCTURED-DATA ===================================
+    out.append(procid);
+    out.append(" - - ");
+
+    // == MSG =================================================================
+    const char *message    = line.text + line.prefix_length;
+    std::size_t msg_length = line.length - line.prefix_length;
+    while ((msg_length > 0) && ((message[msg_length - 1] == '\n') || (message[msg_length - 1] == '\r'))) {
+        --msg_length;
+    }
+    out.append(message, msg_length);
+
+    // Truncate records that are too long.
+    if ((out.size() - start) > max_record_size) {
+        out.resize(start + max_record_size);
+    }
+    entry_ends.push_back(out.size());
+}
+
+void syslog_sink_t::write_device(const char *data, std::size_t length)
+{
+    // Records refused before go first, to keep the order.
+    this->drain_backlog();
+
+    std::size_t start = 0;
+    for (std::size_t i = 0; (i < entry_ends.size()) && (entry_ends[i] <= length); ++i) {
+        const std::size_t record_length = entry_ends[i] - start;
+        send_result_t result            = send_result_t::would_block;
+        if (backlog_ends.empty()) {
+            result = this->send_record(data + start, record_length);
+        }
+        if (result == send_result_t::would_block) {
+            this->enqueue(data + start, record_length);
+        } else if (result == send_result_t::failed) {
+            ++dropped;
+        }
+        start = entry_ends[i];
+    }
+    entry_ends.clear();
+}
+
+void syslog_sink_t::flush_device()
+{
+    this->drain_backlog();
+    // Try again at the next flush.
+    dirty = !backlog_ends.empty();
+}
+
+syslog_sink_t::send_result_t syslog_sink_t::send_record(const char *data, std::size_t length)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    while (true) {
+        const ssize_t result = ::sendto(fd, data, length, 0, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+        if (result >= 0) {
+            return send_result_t::sent;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        // ENOBUFS is what some systems report when the daemon is slow.
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ENOBUFS)) {
+            return send_result_t::would_block;
+        }
+        return send_result_t::failed;
+    }
+}
+
+void syslog_sink_t::drain_backlog()
+{
+    std::size_t sent = 0;
+    for (; sent < backlog_ends.size(); ++sent) {
+        const std::size_t record_length = backlog_ends[sent] - backlog_start;
+        const send_result_t result      = this->send_record(backlog.data() + backlog_start, record_length);
+        if (result == send_result_t::would_block) {
+            break;
+        }
+        if (result == send_result_t::failed) {
+            ++dropped;
+        }
+        backlog_start = backlog_ends[sent];
+    }
+    backlog_ends.erase(backlog_ends.begin(), backlog_ends.begin() + static_cast<std::ptrdiff_t>(sent));
+
+    // Compact the backlog, once most of it has been sent.
+    if (backlog_ends.empty()) {
+        backlog.clear();
+        backlog_start = 0;
+    } else if (backlog_start > (backlog.size() / 2)) {
+        backlog.erase(0, backlog_start);
+        for (std::size_t i = 0; i < backlog_ends.size(); ++i) {
+            backlog_ends[i] -= backlog_start;
+        }
+        backlog_start = 0;
+    }
+    backlog_size = backlog.size() - backlog_start;
+}
+
+void syslog_sink_t::enqueue(const char *data, std::size_t length)
+{
+    if ((backlog.size() - backlog_start + length) > max_backlog_size) {
+        ++dropped;
+        return;
+    }
+    backlog.append(data, length);
+    backlog_ends.push_back(backlog.size());
+    backlog_size = backlog.size() - backlog_start;
+}
+
+} // namespace quire
+
+#endif
@@ -0,0 +1,216 @@
+/// @file test_allocations.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Checks that, once warmed up, logging never allocates memory, with
+/// every combination of the configuration options.
+/// @details Known exceptions, which are not exercised here:
+///  - the first partial line of each thread, and the first use of each buffer;
+///  - qlog_s records nested deeper than four levels, which get their own slot;
+///  - messages longer than ever before, which grow the buffers.
+
+#include <quire/quire.hpp>
+#include <quire/stream.hpp>
+#include <quire/context.hpp>
+#include <quire/sink.hpp>
+
+#include <streambuf>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <new>
+
+/// @brief Allocations done while counting.
+static std::atomic<std::size_t> allocations(0);
+/// @brief Are allocations counted.
+static std::atomic<bool> counting(false);
+
+/// @brief Counts an allocation, if we are counting.
+static inline void __count_allocation()
+{
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+#ifdef __GLIBC__
+// The formatting buffer is handled with realloc, so we replace the C
+// allocator too, forwarding to the one of glibc.
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *memory, std::size_t size);
+
+void *malloc(std::size_t size)
+{
+    __count_allocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size)
+{
+    __count_allocation();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *memory, std::size_t size)
+{
+    __count_allocation();
+    return __libc_realloc(memory, size);
+}
+}
+#endif
+
+/// @brief Allocates memory for the operator new, without counting it twice.
+static inline void *__allocate(std::size_t size)
+{
+    __count_allocation();
+#ifdef __GLIBC__
+    return __libc_malloc(size > 0 ? size : 1);
+#else
+    return std::malloc(size > 0 ? size : 1);
+#endif
+}
+
+void *operator new(std::size_t size)
+{
+    void *memory = __allocate(size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return __allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return __allocate(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+/// @brief A stream buffer discarding everything.
+class null_streambuf_t : public std::streambuf {
+protected:
+    int_type overflow(int_type ch) override
+    {
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char *, std::streamsize n) override
+    {
+        return n;
+    }
+};
+
+/// @brief Logs one message of each kind.
+/// @param logger The logger.
+/// @param large A message larger than the shrink size of the buffer.
+static void log_everything(quire::logger_t &logger, const std::string &large)
+{
+    static const unsigned char data[40] = { 'q', 'u', 'i', 'r', 'e', 0, 1, 2, 0x7f, 0xff };
+
+    logger.log(quire::info, "Plain message %d %s\n", 42, "text");
+    logger.log(quire::warning, __FILE__, __LINE__, "Located message %.3f\n", 3.14);
+    qinfo(logger, "Message through a site %d\n", 7);
+    qinfo_lazy(logger, []() { return "Lazy message\n"; });
+    qinfo_s(logger) << "Stream message " << 42 << ' ' << 1.5;
+    logger.log(quire::info, "Multi-line\nmessage with a \033 control character\n");
+    logger.log(quire::info, "A partial line, ");
+    logger.log(quire::info, "and its end\n");
+    qhexdump(logger, quire::info, data, sizeof(data));
+    {
+        quire::context_guard_t request("request", 1234);
+        logger.log(quire::error, "Message with a context\n");
+    }
+    {
+        quire::record_guard_t<quire::logger_t> record(logger, quire::info, __FILE__, __LINE__);
+        record.append("A record ", 9);
+        record.append("written in chunks", 17);
+    }
+    // A stream of large messages keeps the buffer it needs.
+    logger.log(quire::debug, "%s\n", large.c_str());
+    logger.log(quire::debug, "%s\n", large.c_str());
+}
+
+int main(int, char *[])
+{
+    const std::vector<quire::option_t> options = {
+        quire::option_t::header, quire::option_t::level, quire::option_t::location, quire::option_t::date,
+        quire::option_t::time, quire::option_t::context, quire::option_t::thread
+    };
+    const std::string large(100000, 'x');
+
+    null_streambuf_t null_buffer;
+    std::ostream null_stream(&null_buffer);
+
+    quire::logger_t logger("test", quire::debug, '|');
+    logger.set_output_sink(std::make_shared<quire::ostream_sink_t>(&null_stream));
+    logger.set_file_sink(std::make_shared<quire::ostream_sink_t>(&null_stream));
+    quire::set_thread_name("main");
+
+    int failures = 0;
+    for (unsigned mask = 0; mask < (1U << options.size()); ++mask) {
+        std::vector<quire::option_t> configuration;
+        for (std::size_t i = 0; i < options.size(); ++i) {
+            if (mask & (1U << i)) {
+                configuration.push_back(options[i]);
+            }
+        }
+        for (unsigned variant = 0; variant < 4; ++variant) {
+            logger.configure(configuration);
+            logger.toggle_color((variant & 1U) != 0);
+            logger.toggle_sanitize((variant & 2U) != 0);
+
+            // Warm up, then count.
+            logger.warmup();
+            for (int i = 0; i < 3; ++i) {
+                log_everything(logger, large);
+            }
+            allocations = 0;
+            counting    = true;
+            for (int i = 0; i < 3; ++i) {
+                log_everything(logger, large);
+            }
+            counting = false;
+
+            if (allocations > 0) {
+                std::cerr << "options " << mask << ", variant " << variant << ": " << allocations << " allocations\n";
+                ++failures;
+            }
+        }
+    }
+    if (failures > 0) {
+        std::cerr << failures << " configurations allocate memory.\n";
+        return 1;
+    }
+    std::cout << "No allocations in " << ((1U << options.size()) * 4) << " configurations.\n";
+    return 0;
+}
@@ -0,0 +1,102 @@
+/// @file test_records.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Checks that a buffered file sink writes each record, which fits
+/// the atomic write size, with a single write, whatever the lines buffered
+/// before it.
+
+#include <quire/quire.hpp>
+#include <quire/sink.hpp>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/// @brief The data of each write, while capturing.
+static std::vector<std::string> writes;
+/// @brief Are writes captured.
+static bool capturing = false;
+
+// The file sink writes through write(), which we replace, forwarding to the
+// system call.
+extern "C" ssize_t write(int descriptor, const void *data, size_t length)
+{
+    if (capturing && (descriptor > 2)) {
+        writes.emplace_back(static_cast<const char *>(data), length);
+    }
+    return ::syscall(SYS_write, descriptor, data, length);
+}
+
+int main(int, char *[])
+{
+    const char *path               = "test_records.log";
+    const std::size_t atomic_size  = 1024;
+    const std::string line_padding = std::string(60, '-');
+    const std::string record_line  = std::string(100, 'r') + "\n";
+
+    auto sink = std::make_shared<quire::file_sink_t>(path, atomic_size);
+    sink->set_buffer_capacity(4096);
+    sink->set_flush_level(quire::critical);
+
+    quire::logger_t logger("test", quire::debug, '|');
+    logger.configure({ quire::option_t::level });
+    logger.set_output_sink(nullptr);
+    logger.set_file_sink(sink);
+
+    // Lines and records of many sizes, so that a record often starts when
+    // the buffer is almost full.
+    int records = 0;
+    capturing   = true;
+    for (int i = 0; i < 300; ++i) {
+        logger.log(quire::info, "line %d %s\n", i, line_padding.c_str() + (i % 50));
+        if ((i % 3) == 0) {
+            quire::record_guard_t<quire::logger_t> record(logger, quire::info);
+            const std::string begin = "<record " + std::to_string(records) + ">\n";
+            record.append(begin);
+            for (int j = 0; j < 1 + (i % 8); ++j) {
+                record.append(record_line);
+            }
+            record.append("</record>\n");
+            ++records;
+        }
+    }
+    logger.set_file_sink(nullptr);
+    sink.reset();
+    capturing = false;
+    std::remove(path);
+
+    // Every record must begin and end within the same write.
+    int found = 0, failures = 0;
+    for (std::size_t i = 0; i < writes.size(); ++i) {
+        std::size_t position = 0;
+        while (true) {
+            const std::size_t begin = writes[i].find("<record ", position);
+            const std::size_t end   = writes[i].find("</record>", position);
+            if ((begin == std::string::npos) && (end == std::string::npos)) {
+                break;
+            }
+            if ((begin == std::string::npos) || (end < begin)) {
+                std::cerr << "write " << i << " ends a record it does not begin.\n";
+                ++failures;
+                position = end + 1;
+                continue;
+            }
+            if (end == std::string::npos) {
+                std::cerr << "write " << i << " begins a record it does not end.\n";
+                ++failures;
+                break;
+            }
+            ++found;
+            position = end + 1;
+        }
+    }
+    if ((failures > 0) || (found != records)) {
+        std::cerr << found << " of " << records << " records written at once.\n";
+        return 1;
+    }
+    std::cout << "All " << records << " records written at once, in " << writes.size() << " writes.\n";
+    return 0;
+}
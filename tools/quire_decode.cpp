@@ -0,0 +1,207 @@
+/// @file quire_decode.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Decodes a binary log written by binary_sink_t, on all cores.
+///
+/// Usage: quire-decode [-j <threads>] [-c] <log>
+///
+/// The file is mapped in memory and split in chunks; each chunk starts at
+/// its first sync point, and ends at the first sync point of the next one,
+/// so the chunks are decoded in parallel and printed in file order. Corrupt
+/// data is skipped by looking for the next valid record, and a record cut by
+/// the end of the file (a torn tail) is reported and ignored.
+
+#include <quire/binary_sink.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <condition_variable>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <ctime>
+
+/// @brief A chunk of the file, and its result.
+struct chunk_t {
+    std::size_t begin;   ///< Offset of the first sync point of the chunk.
+    std::size_t end;     ///< Offset of the first sync point of the next chunk.
+    std::string output;  ///< The decoded records.
+    std::size_t records; ///< Number of decoded records.
+    std::size_t skipped; ///< Bytes of corrupt data skipped.
+    std::size_t torn;    ///< Bytes of the torn tail.
+    bool done;           ///< The chunk has been decoded.
+};
+
+/// @brief Renders a record as a line of text.
+static void render_record(std::string &out, const quire::binary::record_view_t &record)
+{
+    const char *levels[] = { "debug   ", "info    ", "warning ", "error   ", "critical" };
+    const std::time_t seconds = static_cast<std::time_t>(record.time / 1000000);
+    std::tm local;
+    ::localtime_r(&seconds, &local);
+    char time[64];
+    std::size_t length = std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", &local);
+    std::snprintf(time + length, sizeof(time) - length, ".%06d", static_cast<int>(record.time % 1000000));
+    out.append(record.header, record.header_len);
+    out.append(" | ");
+    out.append(levels[record.level]);
+    out.append(" | ");
+    out.append(time);
+    out.append(" | ");
+    out.append(record.location, record.location_len);
+    out.append(" | ");
+    out.append(record.message, record.message_len);
+    out.push_back('\n');
+}
+
+/// @brief Decodes a chunk.
+static void decode_chunk(chunk_t &chunk, const char *data, std::size_t size, bool count_only)
+{
+    quire::binary::record_view_t record;
+    std::size_t position = chunk.begin, length;
+    while (position < chunk.end) {
+        const quire::binary::decode_result_t result = quire::binary::decode(data + position, size - position, record, length);
+        if (result == quire::binary::decode_result_t::record) {
+            if (!count_only) {
+                render_record(chunk.output, record);
+            }
+            ++chunk.records;
+            position += length;
+        } else if (result == quire::binary::decode_result_t::sync) {
+            position += length;
+        } else {
+            // Look for the next valid record. A record running past the end
+            // of the file is a torn tail only if nothing valid follows it,
+            // otherwise its length is corrupt, and it is skipped.
+            const std::size_t next = quire::binary::find_record(data, size, position + 1);
+            if ((result == quire::binary::decode_result_t::incomplete) &&
+                ((next == size) || (quire::binary::decode(data + next, size - next, record, length) == quire::binary::decode_result_t::incomplete))) {
+                chunk.torn = size - position;
+                break;
+            }
+            chunk.skipped += std::min(next, chunk.end) - position;
+            position = next;
+        }
+    }
+}
+
+static int usage()
+{
+    std::cerr << "Usage: quire-decode [-j <threads>] [-c] <log>\n";
+    std::cerr << "  -j <threads>  Number of threads, all the cores by default.\n";
+    std::cerr << "  -c            Print only the number of records.\n";
+    return 2;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned threads = std::max(1U, std::thread::hardware_concurrency());
+    bool count_only  = false;
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        if ((option == "-j") && ((i + 1) < argc)) {
+            threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else if (option == "-c") {
+            count_only = true;
+        } else {
+            arguments.emplace_back(option);
+        }
+    }
+    if (arguments.size() != 1) {
+        return usage();
+    }
+
+    // == MAP THE FILE ========================================================
+    int fd = ::open(arguments[0].c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if ((fd < 0) || (::fstat(fd, &info) != 0)) {
+        std::cerr << "Failed to open `" << arguments[0] << "`: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    const std::size_t size = static_cast<std::size_t>(info.st_size);
+    const char *data       = nullptr;
+    if (size > 0) {
+        void *address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            std::cerr << "Failed to map `" << arguments[0] << "`: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        ::madvise(address, size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(address);
+    }
+    ::close(fd);
+
+    // == SPLIT AT SYNC POINTS ================================================
+    // Every chunk begins where the previous one ends, so no record is lost or
+    // decoded twice; the first chunk also covers what precedes the first sync point.
+    const std::size_t chunk_size = std::min<std::size_t>(std::max<std::size_t>(size / (threads * 4U), 1U << 20U), 32U << 20U);
+    std::vector<chunk_t> chunks;
+    std::size_t begin = 0;
+    while (begin < size) {
+        const std::size_t end = std::max(quire::binary::find_sync(data, size, std::min(begin + chunk_size, size)), begin + 1);
+        chunks.push_back(chunk_t{ begin, std::min(end, size), std::string(), 0, 0, 0, false });
+        begin = end;
+    }
+
+    // == DECODE IN PARALLEL, PRINT IN ORDER ==================================
+    // Workers stay at most a few chunks ahead of the output, to bound the memory.
+    const std::size_t window = threads * 2U;
+    std::atomic<std::size_t> next(0);
+    std::size_t printed = 0;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < std::min<std::size_t>(threads, chunks.size()); ++t) {
+        workers.emplace_back([&]() {
+            for (std::size_t index = next++; index < chunks.size(); index = next++) {
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    cv.wait(lock, [&]() { return index < (printed + window); });
+                }
+                decode_chunk(chunks[index], data, size, count_only);
+                std::lock_guard<std::mutex> lock(mtx);
+                chunks[index].done = true;
+                cv.notify_all();
+            }
+        });
+    }
+    std::size_t records = 0, skipped = 0, torn = 0;
+    while (printed < chunks.size()) {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&]() { return chunks[printed].done; });
+        chunk_t &chunk = chunks[printed];
+        lock.unlock();
+        std::fwrite(chunk.output.data(), 1, chunk.output.size(), stdout);
+        records += chunk.records;
+        skipped += chunk.skipped;
+        torn += chunk.torn;
+        std::string().swap(chunk.output);
+        lock.lock();
+        ++printed;
+        cv.notify_all();
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    std::fflush(stdout);
+    if (count_only) {
+        std::cout << records << "\n";
+    }
+    if ((skipped > 0) || (torn > 0)) {
+        std::cerr << "Skipped " << skipped << " corrupt bytes, ignored a torn tail of " << torn << " bytes.\n";
+    }
+    if (data != nullptr) {
+        ::munmap(const_cast<char *>(data), size);
+    }
+    return 0;
+}
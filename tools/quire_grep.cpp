@@ -0,0 +1,405 @@
+/// @file quire_grep.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Searches a log file written by quire, on all cores, with filters
+/// aware of the columns of the lines.
+///
+/// Usage: quire-grep [options] <pattern> <log>
+///
+/// The file is mapped in memory, and split at line boundaries into chunks
+/// searched in parallel; the matching lines are printed in file order. The
+/// pattern is a plain substring, it can be empty to only apply the filters.
+
+#include <quire/quire.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <condition_variable>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+/// @brief What a line must contain to be printed.
+struct filter_t {
+    std::vector<quire::option_t> columns; ///< The columns of the lines, in order.
+    char separator;                       ///< The separator of the columns.
+    std::string delimiter;                ///< The separator, surrounded by spaces.
+    std::string pattern;                  ///< The substring to search.
+    bool message_only;                    ///< The pattern must be in the message.
+    int min_level;                        ///< Minimum level, -1 for any.
+    std::string header;                   ///< Required header, empty for any.
+    std::string location;                 ///< Substring of the location, empty for any.
+};
+
+/// @brief A chunk of the file, and its result.
+struct chunk_t {
+    const char *begin;  ///< Start of the chunk.
+    const char *end;    ///< End of the chunk, just after a newline.
+    std::string output; ///< The matching lines.
+    std::size_t count;  ///< Number of matching lines.
+    bool done;          ///< The chunk has been searched.
+};
+
+/// @brief Finds the first occurrence of the needle.
+/// @details With SSE2, sixteen positions are checked at once by comparing
+/// the first and the last character of the needle, and only the candidates
+/// are compared in full.
+/// @return The position of the occurrence, or nullptr.
+static inline const char *__find(const char *first, const char *last, const std::string &needle)
+{
+    const std::size_t length = needle.size();
+    if (length == 0) {
+        return first;
+    }
+    if (static_cast<std::size_t>(last - first) < length) {
+        return nullptr;
+    }
+    if (length == 1) {
+        return static_cast<const char *>(std::memchr(first, needle[0], static_cast<std::size_t>(last - first)));
+    }
+#if defined(__SSE2__)
+    const __m128i head = _mm_set1_epi8(needle[0]);
+    const __m128i tail = _mm_set1_epi8(needle[length - 1]);
+    for (; (first + length - 1 + 16) <= last; first += 16) {
+        const __m128i block_head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        const __m128i block_tail = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first + length - 1));
+        unsigned mask            = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_head, head), _mm_cmpeq_epi8(block_tail, tail))));
+        while (mask != 0) {
+            const unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (std::memcmp(first + bit + 1, needle.data() + 1, length - 2) == 0) {
+                return first + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    // The remaining positions.
+    for (const char *position = first; (position + length) <= last; ++position) {
+        position = static_cast<const char *>(std::memchr(position, needle[0], static_cast<std::size_t>(last - position) - length + 1));
+        if (position == nullptr) {
+            break;
+        }
+        if (std::memcmp(position + 1, needle.data() + 1, length - 1) == 0) {
+            return position;
+        }
+    }
+    return nullptr;
+}
+
+/// @brief Maps the name of a level to its value, ignoring the padding.
+/// @return The level, or -1 if the name is not a level.
+static inline int __parse_level(const char *first, const char *last)
+{
+    while ((last > first) && (last[-1] == ' ')) {
+        --last;
+    }
+    const std::string name(first, last);
+    const char *names[] = { "debug", "info", "warning", "error", "critical" };
+    for (int level = 0; level < 5; ++level) {
+        if (name == names[level]) {
+            return level;
+        }
+    }
+    return -1;
+}
+
+/// @brief Checks if the text, without its padding, has the shape of the column.
+/// @return true if the column can start at first and end at last.
+static inline bool __is_column(quire::option_t column, const char *first, const char *last)
+{
+    while ((last > first) && (last[-1] == ' ')) {
+        --last;
+    }
+    const std::size_t length = static_cast<std::size_t>(last - first);
+    if (column == quire::option_t::level) {
+        return __parse_level(first, last) >= 0;
+    }
+    if (column == quire::option_t::date) {
+        return (length == 8) && (first[2] == '/') && (first[5] == '/');
+    }
+    if (column == quire::option_t::time) {
+        return (length == 5) && (first[2] == ':');
+    }
+    if (column == quire::option_t::location) {
+        // The file and the line, as `file:line`.
+        const char *digits = last;
+        while ((digits > first) && (digits[-1] >= '0') && (digits[-1] <= '9')) {
+            --digits;
+        }
+        return (digits < last) && (digits > first) && (digits[-1] == ':');
+    }
+    if (column == quire::option_t::context) {
+        // A sequence of `key=value`, starting with a key.
+        const char *equal = static_cast<const char *>(std::memchr(first, '=', length));
+        return (equal != nullptr) && (equal > first) && (std::memchr(first, ' ', static_cast<std::size_t>(equal - first)) == nullptr);
+    }
+    return length > 0;
+}
+
+/// @brief Checks the column against the filters, a missing column is empty.
+/// @return true if the column passes the filters.
+static inline bool __check_column(quire::option_t column, const char *first, const char *last, const filter_t &filter)
+{
+    if (column == quire::option_t::level) {
+        return (filter.min_level < 0) || (__parse_level(first, last) >= filter.min_level);
+    }
+    if (column == quire::option_t::header) {
+        while ((last > first) && (last[-1] == ' ')) {
+            --last;
+        }
+        return filter.header.empty() || (filter.header.compare(0, std::string::npos, first, static_cast<std::size_t>(last - first)) == 0);
+    }
+    if (column == quire::option_t::location) {
+        return filter.location.empty() || (__find(first, last, filter.location) != nullptr);
+    }
+    return true;
+}
+
+/// @brief Matches the columns, starting from the given one, and then the
+/// message. The header, the location and the context are not written when
+/// they are empty, so if a column does not fit, the line is tried without it.
+/// @return true if the line matches.
+static bool __match_columns(const char *first, const char *last, const filter_t &filter, std::size_t index)
+{
+    if (index == filter.columns.size()) {
+        // What is left is the message.
+        return !filter.message_only || (__find(first, last, filter.pattern) != nullptr);
+    }
+    const quire::option_t column = filter.columns[index];
+    const char *end              = __find(first, last, filter.delimiter);
+    if ((end != nullptr) && __is_column(column, first, end)) {
+        if (__check_column(column, first, end, filter) && __match_columns(end + filter.delimiter.size(), last, filter, index + 1)) {
+            return true;
+        }
+    }
+    const bool optional = (column == quire::option_t::header) || (column == quire::option_t::location) || (column == quire::option_t::context);
+    return optional && __check_column(column, first, first, filter) && __match_columns(first, last, filter, index + 1);
+}
+
+/// @brief Checks the columns of the line, and the pattern when it must be
+/// in the message.
+/// @return true if the line matches.
+static inline bool __match_line(const char *first, const char *last, const filter_t &filter)
+{
+    // Without filters, any line containing the pattern matches.
+    if ((filter.min_level < 0) && filter.header.empty() && filter.location.empty() && !filter.message_only) {
+        return true;
+    }
+    return __match_columns(first, last, filter, 0);
+}
+
+/// @brief Searches a chunk.
+static void search_chunk(chunk_t &chunk, const filter_t &filter)
+{
+    const char *position = chunk.begin;
+    while (position < chunk.end) {
+        const char *line_begin, *line_end;
+        if (filter.pattern.empty()) {
+            line_begin = position;
+        } else {
+            // Jump to the next occurrence, and find its line.
+            const char *hit = __find(position, chunk.end, filter.pattern);
+            if (hit == nullptr) {
+                break;
+            }
+            line_begin = hit;
+            while ((line_begin > position) && (line_begin[-1] != '\n')) {
+                --line_begin;
+            }
+            position = hit;
+        }
+        line_end = static_cast<const char *>(std::memchr(position, '\n', static_cast<std::size_t>(chunk.end - position)));
+        line_end = (line_end == nullptr) ? chunk.end : line_end + 1;
+        if (__match_line(line_begin, line_end, filter)) {
+            chunk.output.append(line_begin, line_end);
+            ++chunk.count;
+        }
+        position = line_end;
+    }
+}
+
+/// @brief Parses the list of columns.
+static bool parse_columns(const std::string &text, std::vector<quire::option_t> &columns)
+{
+    columns.clear();
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        std::size_t end = text.find(',', start);
+        end             = (end == std::string::npos) ? text.size() : end;
+        const std::string name(text, start, end - start);
+        if (name == "header") {
+            columns.emplace_back(quire::option_t::header);
+        } else if (name == "level") {
+            columns.emplace_back(quire::option_t::level);
+        } else if (name == "location") {
+            columns.emplace_back(quire::option_t::location);
+        } else if (name == "date") {
+            columns.emplace_back(quire::option_t::date);
+        } else if (name == "time") {
+            columns.emplace_back(quire::option_t::time);
+        } else if (name == "context") {
+            columns.emplace_back(quire::option_t::context);
+        } else if (name == "thread") {
+            columns.emplace_back(quire::option_t::thread);
+        } else if (!name.empty()) {
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+static int usage()
+{
+    std::cerr << "Usage: quire-grep [options] <pattern> <log>\n";
+    std::cerr << "  -l <level>    Only lines at or above the level.\n";
+    std::cerr << "  -H <header>   Only lines with the header.\n";
+    std::cerr << "  -L <text>     Only lines whose location contains the text.\n";
+    std::cerr << "  -m            The pattern must be in the message.\n";
+    std::cerr << "  -c            Print only the number of matching lines.\n";
+    std::cerr << "  -C <columns>  Columns of the lines, `header,level,time,location` by default,\n";
+    std::cerr << "                among header, level, date, time, location, context and thread.\n";
+    std::cerr << "  -s <char>     Separator of the columns, `|` by default.\n";
+    std::cerr << "  -j <threads>  Number of threads, all the cores by default.\n";
+    return 2;
+}
+
+int main(int argc, char *argv[])
+{
+    filter_t filter;
+    filter.columns      = quire::logger_t::get_default_configuation();
+    filter.separator    = '|';
+    filter.message_only = false;
+    filter.min_level    = -1;
+    bool count_only     = false;
+    unsigned threads    = std::max(1U, std::thread::hardware_concurrency());
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        const bool has_value     = (i + 1) < argc;
+        if ((option == "-l") && has_value) {
+            const char *name = argv[++i];
+            filter.min_level = __parse_level(name, name + std::strlen(name));
+            if (filter.min_level < 0) {
+                return usage();
+            }
+        } else if ((option == "-H") && has_value) {
+            filter.header = argv[++i];
+        } else if ((option == "-L") && has_value) {
+            filter.location = argv[++i];
+        } else if (option == "-m") {
+            filter.message_only = true;
+        } else if (option == "-c") {
+            count_only = true;
+        } else if ((option == "-C") && has_value) {
+            if (!parse_columns(argv[++i], filter.columns)) {
+                return usage();
+            }
+        } else if ((option == "-s") && has_value) {
+            filter.separator = argv[++i][0];
+        } else if ((option == "-j") && has_value) {
+            threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else {
+            arguments.emplace_back(option);
+        }
+    }
+    if (arguments.size() != 2) {
+        return usage();
+    }
+    filter.pattern   = arguments[0];
+    filter.delimiter = std::string(" ") + filter.separator + " ";
+
+    // == MAP THE FILE ========================================================
+    int fd = ::open(arguments[1].c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if ((fd < 0) || (::fstat(fd, &info) != 0)) {
+        std::cerr << "Failed to open `" << arguments[1] << "`: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    const std::size_t size = static_cast<std::size_t>(info.st_size);
+    const char *data       = nullptr;
+    if (size > 0) {
+        void *address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            std::cerr << "Failed to map `" << arguments[1] << "`: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        ::madvise(address, size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(address);
+    }
+    ::close(fd);
+
+    // == SPLIT AT LINE BOUNDARIES ============================================
+    const std::size_t chunk_size = std::min<std::size_t>(std::max<std::size_t>(size / (threads * 4U), 1U << 20U), 32U << 20U);
+    std::vector<chunk_t> chunks;
+    for (const char *begin = data; begin < data + size;) {
+        const char *end = begin + std::min(chunk_size, static_cast<std::size_t>(data + size - begin));
+        if (end < (data + size)) {
+            const char *newline = static_cast<const char *>(std::memchr(end, '\n', static_cast<std::size_t>(data + size - end)));
+            end                 = (newline == nullptr) ? data + size : newline + 1;
+        }
+        chunks.push_back(chunk_t{ begin, end, std::string(), 0, false });
+        begin = end;
+    }
+
+    // == SEARCH IN PARALLEL, PRINT IN ORDER ==================================
+    // Workers stay at most a few chunks ahead of the output, to bound the memory.
+    const std::size_t window = threads * 2U;
+    std::atomic<std::size_t> next(0);
+    std::size_t printed = 0;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < std::min<std::size_t>(threads, chunks.size()); ++t) {
+        workers.emplace_back([&]() {
+            for (std::size_t index = next++; index < chunks.size(); index = next++) {
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    cv.wait(lock, [&]() { return index < (printed + window); });
+                }
+                search_chunk(chunks[index], filter);
+                std::lock_guard<std::mutex> lock(mtx);
+                chunks[index].done = true;
+                cv.notify_all();
+            }
+        });
+    }
+    std::size_t count = 0;
+    while (printed < chunks.size()) {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&]() { return chunks[printed].done; });
+        chunk_t &chunk = chunks[printed];
+        lock.unlock();
+        if (!count_only) {
+            std::fwrite(chunk.output.data(), 1, chunk.output.size(), stdout);
+        }
+        count += chunk.count;
+        std::string().swap(chunk.output);
+        lock.lock();
+        ++printed;
+        cv.notify_all();
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    if (count_only) {
+        std::cout << count << "\n";
+    }
+    if (data != nullptr) {
+        ::munmap(const_cast<char *>(data), size);
+    }
+    return (count > 0) ? 0 : 1;
+}
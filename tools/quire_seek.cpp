@@ -0,0 +1,211 @@
+/// @file quire_seek.cpp
+/// @author Enrico Fraccaroli (enry.frak@gmail.com)
+/// @brief Prints the lines of a log file written within a time range, using
+/// the time index written by the file sink to jump straight to them.
+///
+/// Usage: quire-seek [-i <index>] [-l] <log> <from> [<to>]
+///
+/// Times can be given as `YYYY-MM-DD HH:MM:SS`, as `HH:MM[:SS]` of the day
+/// of the first indexed line, or as `@<seconds since the epoch>`. Since the
+/// index is sparse, the output can start and end up to one index interval
+/// outside the range.
+
+#include <quire/sink.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <ctime>
+
+/// @brief A read-only memory mapping of a whole file.
+struct mapping_t {
+    const char *data; ///< The content of the file.
+    std::size_t size; ///< Size of the file.
+
+    mapping_t()
+        : data(nullptr),
+          size(0)
+    {
+        // Nothing to do.
+    }
+
+    ~mapping_t()
+    {
+        if (data != nullptr) {
+            ::munmap(const_cast<char *>(data), size);
+        }
+    }
+
+    /// @brief Maps the file.
+    /// @param path Path of the file.
+    /// @return true on success, an empty file is mapped as an empty range.
+    bool open(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size = static_cast<std::size_t>(info.st_size);
+        if (size > 0) {
+            void *address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (address == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+            data = static_cast<const char *>(address);
+        }
+        ::close(fd);
+        return true;
+    }
+};
+
+/// @brief Parses a time.
+/// @param text The time, see the usage.
+/// @param day The day used when only the time of the day is given.
+/// @param time Where the time is stored, in microseconds since the epoch.
+/// @return true on success.
+static bool parse_time(const std::string &text, std::time_t day, std::int64_t &time)
+{
+    if (!text.empty() && (text[0] == '@')) {
+        char *end;
+        const double seconds = std::strtod(text.c_str() + 1, &end);
+        time                 = static_cast<std::int64_t>(seconds * 1e6);
+        return *end == '\0';
+    }
+    std::tm local;
+    ::localtime_r(&day, &local);
+    local.tm_sec = 0;
+    int fields   = std::sscanf(text.c_str(), "%d-%d-%d%*[ T]%d:%d:%d", &local.tm_year, &local.tm_mon, &local.tm_mday, &local.tm_hour, &local.tm_min, &local.tm_sec);
+    if (fields >= 5) {
+        local.tm_year -= 1900;
+        local.tm_mon -= 1;
+    } else {
+        std::tm today;
+        ::localtime_r(&day, &today);
+        local = today;
+        local.tm_sec = 0;
+        fields = std::sscanf(text.c_str(), "%d:%d:%d", &local.tm_hour, &local.tm_min, &local.tm_sec);
+        if (fields < 2) {
+            return false;
+        }
+    }
+    local.tm_isdst = -1;
+    time           = static_cast<std::int64_t>(std::mktime(&local)) * 1000000;
+    return true;
+}
+
+/// @brief Formats a time, for listing the index.
+static std::string format_time(std::int64_t time)
+{
+    const std::time_t seconds = static_cast<std::time_t>(time / 1000000);
+    std::tm local;
+    ::localtime_r(&seconds, &local);
+    char text[64];
+    std::size_t length = std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+    std::snprintf(text + length, sizeof(text) - length, ".%06d", static_cast<int>(time % 1000000));
+    return text;
+}
+
+static int usage()
+{
+    std::cerr << "Usage: quire-seek [-i <index>] [-l] <log> <from> [<to>]\n";
+    std::cerr << "  -i <index>  Path of the index, `<log>.idx` by default.\n";
+    std::cerr << "  -l          List the entries of the index.\n";
+    std::cerr << "Times: `YYYY-MM-DD HH:MM:SS`, `HH:MM[:SS]`, or `@<seconds since the epoch>`.\n";
+    return 2;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string index_path;
+    std::vector<std::string> arguments;
+    bool list = false;
+    for (int i = 1; i < argc; ++i) {
+        if ((std::strcmp(argv[i], "-i") == 0) && ((i + 1) < argc)) {
+            index_path = argv[++i];
+        } else if (std::strcmp(argv[i], "-l") == 0) {
+            list = true;
+        } else {
+            arguments.emplace_back(argv[i]);
+        }
+    }
+    if (arguments.empty() || (!list && (arguments.size() < 2)) || (arguments.size() > 3)) {
+        return usage();
+    }
+    if (index_path.empty()) {
+        index_path = arguments[0] + ".idx";
+    }
+
+    mapping_t log, index;
+    if (!log.open(arguments[0])) {
+        std::cerr << "Failed to open `" << arguments[0] << "`: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    if (!index.open(index_path)) {
+        std::cerr << "Failed to open `" << index_path << "`: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    // A torn entry at the end of the index is ignored.
+    const quire::time_index_entry_t *first = reinterpret_cast<const quire::time_index_entry_t *>(index.data);
+    const quire::time_index_entry_t *last  = first + (index.size / sizeof(quire::time_index_entry_t));
+
+    // Entries of processes sharing the file can be slightly out of order.
+    std::vector<quire::time_index_entry_t> sorted;
+    const auto by_offset = [](const quire::time_index_entry_t &a, const quire::time_index_entry_t &b) {
+        return a.offset < b.offset;
+    };
+    if (!std::is_sorted(first, last, by_offset)) {
+        sorted.assign(first, last);
+        std::stable_sort(sorted.begin(), sorted.end(), by_offset);
+        first = sorted.data();
+        last  = first + sorted.size();
+    }
+
+    if (list) {
+        for (const quire::time_index_entry_t *entry = first; entry != last; ++entry) {
+            std::cout << format_time(entry->time) << " " << entry->offset << "\n";
+        }
+        return 0;
+    }
+
+    const std::time_t day = (first != last) ? static_cast<std::time_t>(first->time / 1000000) : std::time(nullptr);
+    std::int64_t from, to = INT64_MAX;
+    if (!parse_time(arguments[1], day, from) || ((arguments.size() == 3) && !parse_time(arguments[2], day, to))) {
+        return usage();
+    }
+
+    // Start from the last entry written before the range, and stop at the
+    // first one written after it.
+    const quire::time_index_entry_t *begin = std::partition_point(first, last, [from](const quire::time_index_entry_t &entry) {
+        return entry.time <= from;
+    });
+    const quire::time_index_entry_t *end = std::partition_point(begin, last, [to](const quire::time_index_entry_t &entry) {
+        return entry.time <= to;
+    });
+    std::size_t start_offset = (begin != first) ? static_cast<std::size_t>((begin - 1)->offset) : 0;
+    std::size_t end_offset   = (end != last) ? static_cast<std::size_t>(end->offset) : log.size;
+    start_offset             = std::min(start_offset, log.size);
+    end_offset               = std::max(std::min(end_offset, log.size), start_offset);
+
+    if (end_offset > start_offset) {
+        ::madvise(const_cast<char *>(log.data) + (start_offset & ~static_cast<std::size_t>(::getpagesize() - 1)),
+                  end_offset - (start_offset & ~static_cast<std::size_t>(::getpagesize() - 1)), MADV_SEQUENTIAL);
+        std::fwrite(log.data + start_offset, 1, end_offset - start_offset, stdout);
+    }
+    return 0;
+}